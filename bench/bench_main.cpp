@@ -0,0 +1,36 @@
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+
+#include "benchmarks.h"
+#include "synthetic_tree.h"
+
+// Usage: ContextBenchmarks [--huge] [--benchmark_filter=...] [--benchmark_out=results.json ...]
+// --huge adds a 1M-file tree to every shape-parameterised benchmark. It takes a while
+// to generate and needs a few GB of temp space, so it is off by default.
+int main(int argc, char** argv)
+{
+    int kept = 1;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--huge") == 0) {
+            SetIncludeHugeTrees(true);
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    RegisterScanBenchmarks();
+    RegisterSelectionBenchmarks();
+    RegisterProjectBenchmarks();
+    RegisterGenerateBenchmarks();
+    RegisterFrameBenchmarks();
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+// Each bench/*_bench.cpp registers its benchmarks here, once the command line
+// has been parsed and the set of tree shapes is known.
+void RegisterScanBenchmarks();
+void RegisterSelectionBenchmarks();
+void RegisterProjectBenchmarks();
+void RegisterGenerateBenchmarks();
+void RegisterFrameBenchmarks();
@@ -0,0 +1,207 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "imgui.h"
+
+#include "benchmarks.h"
+#include "context_generator.h"
+#include "frame_arena.h"
+#include "metrics.h"
+#include "selection.h"
+#include "synthetic_tree.h"
+#include "tree_view.h"
+
+namespace {
+
+// ImGui without a platform or renderer backend. NewFrame/Render do all their usual
+// work; the draw data is just never submitted to a GPU.
+class HeadlessImGui
+{
+public:
+    HeadlessImGui()
+    {
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
+        ImGuiIO& io = ImGui::GetIO();
+        io.DisplaySize = ImVec2(1280.0f, 800.0f);
+        io.DeltaTime = 1.0f / 60.0f;
+        io.IniFilename = nullptr;
+        // Building the atlas is all the font setup NewFrame needs; the texture is never uploaded.
+        unsigned char* pixels = nullptr;
+        int width = 0, height = 0;
+        io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+    }
+    ~HeadlessImGui() { ImGui::DestroyContext(); }
+
+    HeadlessImGui(const HeadlessImGui&) = delete;
+    HeadlessImGui& operator=(const HeadlessImGui&) = delete;
+};
+
+enum class FrameScript
+{
+    Collapsed,  // Only the root's children visible
+    ExpandAll,  // Every directory open, nothing moving
+    Scroll,     // Every directory open, scrolling half a screen per frame
+    Toggle      // Every directory open, a top-level directory checked/unchecked every frame
+};
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Per-frame percentiles; Google Benchmark itself only reports the mean.
+void ReportFrameTimes(benchmark::State& state, std::vector<double>& frame_ms)
+{
+    if (frame_ms.empty()) {
+        return;
+    }
+    std::sort(frame_ms.begin(), frame_ms.end());
+    auto percentile = [&](double p) { return frame_ms[static_cast<size_t>(p * (frame_ms.size() - 1))]; };
+    state.counters["p50_ms"] = percentile(0.50);
+    state.counters["p99_ms"] = percentile(0.99);
+    state.counters["max_ms"] = frame_ms.back();
+}
+
+uint32_t FirstTopLevelDirectory(const FileTree& tree)
+{
+    const FileNode& root = tree.nodes[0];
+    return root.child_count > 0 && tree.nodes[root.first_child].is_directory ? root.first_child : 0;
+}
+
+// Frames ImGui needs to create its windows and apply the open state before we measure.
+constexpr int kWarmupFrames = 3;
+
+} // namespace
+
+// --- Directory tree ---
+
+static void BM_TreeFrame(benchmark::State& state, SyntheticTreeShape shape, FrameScript script)
+{
+    const FileTree tree = ScanFileTree(SyntheticTreeRoot(shape));
+    const std::string& root = tree.root_path;
+    const uint32_t toggle_target = FirstTopLevelDirectory(tree);
+    const fs::path toggle_path = tree.Path(toggle_target);
+    SelectionMap selection;
+    directory_state_cache.clear();
+
+    HeadlessImGui imgui;
+    int frame = 0;
+    float scroll = 0.0f;
+    bool toggle_selected = true;
+    auto draw_frame = [&]()
+    {
+        ImGui::NewFrame();
+        if (frame == 0 && script != FrameScript::Collapsed) {
+            SetDirectoryTreeOpen(true);
+        }
+        if (script == FrameScript::Toggle && frame >= kWarmupFrames)
+        {
+            // What the tree's checkbox click handler does.
+            SetSelectionRecursively(tree, toggle_target, toggle_path, toggle_selected, selection);
+            InvalidateParentCaches(toggle_path);
+            toggle_selected = !toggle_selected;
+        }
+
+        ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f));
+        ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+        ImGui::Begin("Frame Benchmark", nullptr, ImGuiWindowFlags_NoDecoration);
+        ImGui::BeginChild("DirectoryTree", ImVec2(0, 0), true);
+        if (script == FrameScript::Scroll)
+        {
+            scroll += ImGui::GetIO().DisplaySize.y * 0.5f;
+            if (scroll > ImGui::GetScrollMaxY()) {
+                scroll = 0.0f;
+            }
+            ImGui::SetScrollY(scroll);
+        }
+        DrawDirectoryTree(tree, 0, root, selection);
+        ImGui::EndChild();
+        ImGui::End();
+        ImGui::Render();
+        GetFrameArena().Reset();
+        frame++;
+    };
+
+    for (int i = 0; i < kWarmupFrames; ++i) {
+        draw_frame();
+    }
+    std::vector<double> frame_ms;
+    const uint64_t allocations_before = thread_heap_allocations;
+    for (auto _ : state)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        draw_frame();
+        frame_ms.push_back(MillisecondsSince(start));
+    }
+    ReportFrameTimes(state, frame_ms);
+    state.counters["allocs/frame"] = benchmark::Counter(static_cast<double>(thread_heap_allocations - allocations_before), benchmark::Counter::kAvgIterations);
+    state.counters["vertices"] = static_cast<double>(ImGui::GetDrawData()->TotalVtxCount);
+    directory_state_cache.clear();
+}
+
+// --- Context viewer ---
+
+// The read-only InputTextMultiline holding the generated context for the whole tree.
+static void BM_ViewerFrame(benchmark::State& state, SyntheticTreeShape shape)
+{
+    const FileTree tree = ScanFileTree(SyntheticTreeRoot(shape));
+    SelectionMap selection;
+    for (uint32_t i = 0; i < tree.nodes.size(); ++i)
+    {
+        if (!tree.nodes[i].is_directory) {
+            selection[tree.Path(i).string()] = true;
+        }
+    }
+    std::string text;
+    ContextStats stats;
+    GenerateContext(selection, ContextOptions(), text, stats);
+
+    HeadlessImGui imgui;
+    auto draw_frame = [&]()
+    {
+        ImGui::NewFrame();
+        ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f));
+        ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+        ImGui::Begin("Frame Benchmark", nullptr, ImGuiWindowFlags_NoDecoration);
+        DrawContextViewer(text);
+        ImGui::End();
+        ImGui::Render();
+    };
+
+    for (int i = 0; i < kWarmupFrames; ++i) {
+        draw_frame();
+    }
+    std::vector<double> frame_ms;
+    for (auto _ : state)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        draw_frame();
+        frame_ms.push_back(MillisecondsSince(start));
+    }
+    ReportFrameTimes(state, frame_ms);
+    state.counters["text_MB"] = static_cast<double>(text.size()) / (1024.0 * 1024.0);
+}
+
+void RegisterFrameBenchmarks()
+{
+    const std::pair<const char*, FrameScript> scripts[] = {
+        {"collapsed", FrameScript::Collapsed},
+        {"expand_all", FrameScript::ExpandAll},
+        {"scroll", FrameScript::Scroll},
+        {"toggle", FrameScript::Toggle},
+    };
+    for (const SyntheticTreeShape& shape : BenchmarkShapes())
+    {
+        // A fixed frame count, so p99 always has enough samples behind it.
+        const int frames = std::string(shape.name) == "huge" ? 20 : 120;
+        for (const auto& [name, script] : scripts)
+        {
+            std::string benchmark_name = std::string("TreeFrame/") + shape.name + "/" + name;
+            benchmark::RegisterBenchmark(benchmark_name.c_str(), BM_TreeFrame, shape, script)->Iterations(frames)->Unit(benchmark::kMillisecond);
+        }
+        benchmark::RegisterBenchmark((std::string("ViewerFrame/") + shape.name).c_str(), BM_ViewerFrame, shape)->Iterations(frames)->Unit(benchmark::kMillisecond);
+    }
+}
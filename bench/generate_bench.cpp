@@ -0,0 +1,52 @@
+#include <benchmark/benchmark.h>
+
+#include "benchmarks.h"
+#include "context_generator.h"
+#include "file_tree.h"
+#include "synthetic_tree.h"
+
+// --- Context generation ---
+
+static void BM_GenerateContext(benchmark::State& state, SyntheticTreeShape shape, ContextOptions options)
+{
+    const FileTree tree = ScanFileTree(SyntheticTreeRoot(shape));
+    SelectionMap selection;
+    for (uint32_t i = 0; i < tree.nodes.size(); ++i)
+    {
+        if (!tree.nodes[i].is_directory) {
+            selection[tree.Path(i).string()] = true;
+        }
+    }
+
+    ContextStats stats;
+    for (auto _ : state)
+    {
+        std::string text;
+        GenerateContext(selection, options, text, stats);
+        benchmark::DoNotOptimize(text.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * stats.bytes_read));
+    state.counters["files/s"] = benchmark::Counter(static_cast<double>(state.iterations() * stats.file_count), benchmark::Counter::kIsRate);
+    state.counters["tokens"] = static_cast<double>(stats.token_count);
+}
+
+void RegisterGenerateBenchmarks()
+{
+    const std::pair<const char*, ContextOptions> modes[] = {
+        {"verbatim", {false, TransformMode::None}},
+        {"dedupe", {true, TransformMode::None}},
+        {"strip", {true, TransformMode::StripComments}},
+        {"outline", {true, TransformMode::Outline}},
+        {"markdown", {true, TransformMode::None, OutputFormat::Markdown}},
+        {"xml", {true, TransformMode::None, OutputFormat::Xml}},
+        {"jsonl", {true, TransformMode::None, OutputFormat::JsonLines}},
+    };
+    for (const SyntheticTreeShape& shape : BenchmarkShapes())
+    {
+        for (const auto& [mode, options] : modes)
+        {
+            std::string name = std::string("GenerateContext/") + shape.name + "/" + mode;
+            benchmark::RegisterBenchmark(name.c_str(), BM_GenerateContext, shape, options)->Unit(benchmark::kMillisecond)->UseRealTime();
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+
+#include "benchmarks.h"
+#include "projects.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::vector<Project> MakeProjects(int project_count, int paths_per_project)
+{
+    std::vector<Project> projects(project_count);
+    for (int p = 0; p < project_count; ++p)
+    {
+        projects[p].name = "Project " + std::to_string(p);
+        projects[p].root_paths = {"/home/user/src/project_" + std::to_string(p)};
+        for (int i = 0; i < paths_per_project; ++i) {
+            projects[p].selected_paths.push_back(projects[p].root_paths[0] + "/src/module_" + std::to_string(i / 50) + "/file_" + std::to_string(i) + ".cpp");
+        }
+    }
+    return projects;
+}
+
+std::string BenchProjectsFile()
+{
+    return (fs::temp_directory_path() / "acb_bench_projects.json").string();
+}
+
+} // namespace
+
+// --- projects.json ---
+
+static void BM_SaveProjects(benchmark::State& state)
+{
+    const std::vector<Project> projects = MakeProjects(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    const std::string file = BenchProjectsFile();
+    for (auto _ : state) {
+        SaveProjects(projects, file);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * fs::file_size(file)));
+    fs::remove(file);
+}
+
+static void BM_LoadProjects(benchmark::State& state)
+{
+    const std::string file = BenchProjectsFile();
+    SaveProjects(MakeProjects(static_cast<int>(state.range(0)), static_cast<int>(state.range(1))), file);
+    for (auto _ : state)
+    {
+        std::vector<Project> projects = LoadProjects(file);
+        benchmark::DoNotOptimize(projects.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * fs::file_size(file)));
+    fs::remove(file);
+}
+
+void RegisterProjectBenchmarks()
+{
+    // {projects, selected paths per project}
+    benchmark::RegisterBenchmark("SaveProjects", BM_SaveProjects)->Args({10, 100})->Args({20, 10000})->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("LoadProjects", BM_LoadProjects)->Args({10, 100})->Args({20, 10000})->Unit(benchmark::kMillisecond);
+}
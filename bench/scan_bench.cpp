@@ -0,0 +1,45 @@
+#include <benchmark/benchmark.h>
+
+#include "benchmarks.h"
+#include "file_tree.h"
+#include "synthetic_tree.h"
+
+// --- Enumeration ---
+
+static void BM_ScanFileTree(benchmark::State& state, SyntheticTreeShape shape)
+{
+    const std::string& root = SyntheticTreeRoot(shape);
+    size_t node_count = 0;
+    for (auto _ : state)
+    {
+        FileTree tree = ScanFileTree(root);
+        node_count = tree.nodes.size();
+        benchmark::DoNotOptimize(tree.nodes.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * node_count));
+    state.counters["nodes"] = static_cast<double>(node_count);
+}
+
+// Re-scan with an up-to-date previous tree, as after loading the scan index:
+// every directory listing is reused and only the directory mtimes are checked.
+static void BM_RevalidateFileTree(benchmark::State& state, SyntheticTreeShape shape)
+{
+    const std::string& root = SyntheticTreeRoot(shape);
+    const FileTree previous = ScanFileTree(root);
+    for (auto _ : state)
+    {
+        FileTree tree = ScanFileTree(root, nullptr, &previous);
+        benchmark::DoNotOptimize(tree.nodes.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * previous.nodes.size()));
+    state.counters["nodes"] = static_cast<double>(previous.nodes.size());
+}
+
+void RegisterScanBenchmarks()
+{
+    for (const SyntheticTreeShape& shape : BenchmarkShapes())
+    {
+        benchmark::RegisterBenchmark((std::string("ScanFileTree/") + shape.name).c_str(), BM_ScanFileTree, shape)->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark((std::string("RevalidateFileTree/") + shape.name).c_str(), BM_RevalidateFileTree, shape)->Unit(benchmark::kMillisecond);
+    }
+}
@@ -0,0 +1,105 @@
+#include <benchmark/benchmark.h>
+
+#include "benchmarks.h"
+#include "selection.h"
+#include "synthetic_tree.h"
+
+namespace {
+
+// Every other file selected, so most directories end up partially selected and the
+// state walk can stop early; with every_file set the walk has to visit every node.
+SelectionMap AlternatingSelection(const FileTree& tree, bool every_file = false)
+{
+    SelectionMap selection;
+    for (uint32_t i = 0; i < tree.nodes.size(); ++i)
+    {
+        if (!tree.nodes[i].is_directory && (every_file || i % 2 == 0)) {
+            selection[tree.Path(i).string()] = true;
+        }
+    }
+    return selection;
+}
+
+// The directory with the most nodes below it among the root's children.
+uint32_t LargestTopLevelDirectory(const FileTree& tree)
+{
+    const FileNode& root = tree.nodes[0];
+    uint32_t best = 0;
+    uint32_t best_size = 0;
+    for (uint32_t child = root.first_child; child < root.first_child + root.child_count; ++child)
+    {
+        if (!tree.nodes[child].is_directory) {
+            continue;
+        }
+        uint32_t size = 0;
+        std::vector<uint32_t> stack = {child};
+        while (!stack.empty())
+        {
+            const FileNode& node = tree.nodes[stack.back()];
+            stack.pop_back();
+            size++;
+            for (uint32_t c = 0; c < node.child_count; ++c) {
+                stack.push_back(node.first_child + c);
+            }
+        }
+        if (size > best_size) {
+            best = child;
+            best_size = size;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+// --- Tri-state computation ---
+
+// The whole tree from an empty cache, as after a rescan or "Recalculate States".
+static void BM_DirectoryStateCold(benchmark::State& state, SyntheticTreeShape shape, bool every_file)
+{
+    const FileTree tree = ScanFileTree(SyntheticTreeRoot(shape));
+    const SelectionMap selection = AlternatingSelection(tree, every_file);
+    const std::string& root = tree.root_path;
+    for (auto _ : state)
+    {
+        directory_state_cache.clear();
+        benchmark::DoNotOptimize(CalculateAndCacheDirectoryState(tree, 0, root, selection));
+    }
+    directory_state_cache.clear();
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * tree.nodes.size()));
+}
+
+// --- Toggling ---
+
+// Checking a large directory: select the subtree, invalidate its parents and recompute
+// the root state, the same sequence as a checkbox click in the tree view.
+static void BM_ToggleDirectory(benchmark::State& state, SyntheticTreeShape shape)
+{
+    const FileTree tree = ScanFileTree(SyntheticTreeRoot(shape));
+    SelectionMap selection = AlternatingSelection(tree);
+    const std::string& root = tree.root_path;
+    const uint32_t target = LargestTopLevelDirectory(tree);
+    const fs::path target_path = tree.Path(target);
+
+    directory_state_cache.clear();
+    CalculateAndCacheDirectoryState(tree, 0, root, selection);
+    bool selected = true;
+    for (auto _ : state)
+    {
+        SetSelectionRecursively(tree, target, target_path, selected, selection);
+        InvalidateParentCaches(target_path);
+        benchmark::DoNotOptimize(CalculateAndCacheDirectoryState(tree, 0, root, selection));
+        selected = !selected;
+    }
+    directory_state_cache.clear();
+}
+
+void RegisterSelectionBenchmarks()
+{
+    for (const SyntheticTreeShape& shape : BenchmarkShapes())
+    {
+        benchmark::RegisterBenchmark((std::string("DirectoryStateCold/") + shape.name + "/partial").c_str(), BM_DirectoryStateCold, shape, false)->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark((std::string("DirectoryStateCold/") + shape.name + "/full").c_str(), BM_DirectoryStateCold, shape, true)->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark((std::string("ToggleDirectory/") + shape.name).c_str(), BM_ToggleDirectory, shape)->Unit(benchmark::kMicrosecond);
+    }
+}
@@ -0,0 +1,60 @@
+#include "synthetic_tree.h"
+
+#include <chrono>
+#include <iostream>
+#include <map>
+
+static bool include_huge_trees = false;
+
+void SetIncludeHugeTrees(bool include)
+{
+    include_huge_trees = include;
+}
+
+std::vector<SyntheticTreeShape> BenchmarkShapes()
+{
+    std::vector<SyntheticTreeShape> shapes;
+    for (const char* name : {"wide", "deep", "mixed", "huge"})
+    {
+        if (std::string(name) == "huge" && !include_huge_trees) {
+            continue;
+        }
+        SyntheticTreeShape shape{name, {}};
+        FixturePreset(name, shape.spec);
+        shapes.push_back(shape);
+    }
+    return shapes;
+}
+
+namespace {
+// Removes every generated tree when the benchmark binary exits.
+struct TreeRegistry
+{
+    std::map<std::string, std::string> roots;
+    ~TreeRegistry()
+    {
+        for (const auto& [name, root] : roots)
+        {
+            std::error_code ec;
+            fs::remove_all(root, ec);
+        }
+    }
+};
+}
+
+const std::string& SyntheticTreeRoot(const SyntheticTreeShape& shape)
+{
+    static TreeRegistry registry;
+    auto it = registry.roots.find(shape.name);
+    if (it != registry.roots.end()) {
+        return it->second;
+    }
+
+    // A unique name, so concurrent runs and leftovers from a crashed run do not collide.
+    const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    fs::path root = DefaultFixtureDirectory() / ("acb_bench_" + std::string(shape.name) + "_" + std::to_string(stamp));
+    std::cerr << "Generating " << shape.name << " tree in " << root.string() << "..." << std::endl;
+    FixtureStats stats = CreateFixture(root, shape.spec);
+    std::cerr << "  " << stats.files << " files, " << stats.directories << " directories, " << stats.bytes << " bytes" << std::endl;
+    return registry.roots[shape.name] = root.string();
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "fixture_generator.h"
+
+struct SyntheticTreeShape
+{
+    const char* name;   // A FixturePreset name
+    FixtureSpec spec;
+};
+
+// wide, deep and mixed; plus the 1M-file "huge" preset when enabled with --huge.
+std::vector<SyntheticTreeShape> BenchmarkShapes();
+void SetIncludeHugeTrees(bool include);
+
+// Generates the fixture on first use and returns its root. Fixtures go to
+// DefaultFixtureDirectory() and are removed when the process exits.
+const std::string& SyntheticTreeRoot(const SyntheticTreeShape& shape);
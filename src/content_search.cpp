@@ -0,0 +1,119 @@
+#include "content_search.h"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <regex>
+
+#include "mapped_file.h"
+#include "parallel.h"
+#include "simd_search.h"
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+
+static bool LooksBinary(std::string_view content)
+{
+    return content.substr(0, 8192).find('\0') != std::string_view::npos;
+}
+
+// std::regex is recursive in most implementations, so it is run per line to keep
+// the stack bounded on large files.
+static bool RegexMatchesAnyLine(std::string_view content, const std::regex& re)
+{
+    size_t line_begin = 0;
+    while (line_begin <= content.size())
+    {
+        size_t line_end = FindByte(content.data(), line_begin, content.size(), '\n');
+        if (line_end == kNotFound) {
+            line_end = content.size();
+        }
+        if (std::regex_search(content.data() + line_begin, content.data() + line_end, re)) {
+            return true;
+        }
+        line_begin = line_end + 1;
+    }
+    return false;
+}
+
+ContentSearchResult SearchContents(const FileTree& tree, const ContentSearchOptions& options, const std::atomic<bool>* cancel)
+{
+    ZoneScoped;
+    ContentSearchResult result;
+    if (options.pattern.empty()) {
+        return result;
+    }
+
+    std::unique_ptr<std::regex> re;
+    if (options.use_regex)
+    {
+        try {
+            auto flags = std::regex::ECMAScript | std::regex::optimize;
+            if (options.ignore_case) {
+                flags |= std::regex::icase;
+            }
+            re = std::make_unique<std::regex>(options.pattern, flags);
+        } catch (const std::regex_error& e) {
+            result.error = e.what();
+            return result;
+        }
+    }
+
+    std::vector<uint32_t> files;
+    for (uint32_t node = 0; node < tree.nodes.size(); ++node)
+    {
+        if (!tree.nodes[node].is_directory && tree.nodes[node].size > 0) {
+            files.push_back(node);
+        }
+    }
+
+    struct WorkerResult
+    {
+        std::vector<uint32_t> nodes;
+        size_t files_searched = 0;
+        uint64_t bytes_searched = 0;
+    };
+    std::vector<WorkerResult> per_worker(WorkerCount());
+
+    // Small batches: file sizes vary wildly, so work is claimed a few files at a time.
+    ParallelFor(files.size(), 8, [&](size_t begin, size_t end, size_t worker) {
+        WorkerResult& out = per_worker[worker];
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (cancel && cancel->load(std::memory_order_relaxed)) {
+                return;
+            }
+            MappedFile file(tree.Path(files[i]).string());
+            if (!file.IsValid()) {
+                continue;
+            }
+            std::string_view content = file.View();
+            if (LooksBinary(content)) {
+                continue;
+            }
+            out.files_searched++;
+            out.bytes_searched += content.size();
+
+            bool matched = false;
+            try {
+                matched = re ? RegexMatchesAnyLine(content, *re)
+                             : FindSubstring(content.data(), content.size(), options.pattern.data(), options.pattern.size(), options.ignore_case) != kNotFound;
+            } catch (const std::regex_error& e) {
+                std::cerr << "Regex error in " << tree.Path(files[i]).string() << ": " << e.what() << std::endl;
+            }
+            if (matched) {
+                out.nodes.push_back(files[i]);
+            }
+        }
+    });
+
+    for (const auto& out : per_worker)
+    {
+        result.nodes.insert(result.nodes.end(), out.nodes.begin(), out.nodes.end());
+        result.files_searched += out.files_searched;
+        result.bytes_searched += out.bytes_searched;
+    }
+    std::sort(result.nodes.begin(), result.nodes.end());
+    return result;
+}
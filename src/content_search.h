@@ -0,0 +1,28 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "file_tree.h"
+
+struct ContentSearchOptions
+{
+    std::string pattern;
+    bool use_regex = false;     // ECMAScript regex, matched line by line
+    bool ignore_case = false;
+};
+
+struct ContentSearchResult
+{
+    std::vector<uint32_t> nodes;   // Matching files, in tree order
+    size_t files_searched = 0;
+    uint64_t bytes_searched = 0;
+    std::string error;             // Set if the pattern could not be compiled
+};
+
+// Searches the contents of every file in the tree on all cores. Files are memory
+// mapped and handed out one small batch at a time, so a few huge files do not
+// hold up the rest. Files that look binary (a NUL byte in the first 8 KiB) are skipped.
+ContentSearchResult SearchContents(const FileTree& tree, const ContentSearchOptions& options, const std::atomic<bool>* cancel = nullptr);
@@ -0,0 +1,177 @@
+#include "context_export.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include <zstd.h>
+
+#include "mapped_file.h"
+#include "parallel.h"
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+namespace fs = std::filesystem;
+
+
+bool ExportCompressedContext(const SelectionMap& selection, const ContextOptions& options, const std::string& path,
+                             ContextStats& stats, CompressedExportStats& export_stats, int level)
+{
+    ZoneScoped;
+    export_stats = {};
+
+    std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> context(ZSTD_createCCtx(), ZSTD_freeCCtx);
+    if (!context) {
+        std::cerr << "Could not create a zstd compression context" << std::endl;
+        return false;
+    }
+    ZSTD_CCtx_setParameter(context.get(), ZSTD_c_compressionLevel, level);
+    ZSTD_CCtx_setParameter(context.get(), ZSTD_c_checksumFlag, 1);
+    // Fails harmlessly on a zstd built without threads, which then compresses inline.
+    ZSTD_CCtx_setParameter(context.get(), ZSTD_c_nbWorkers, static_cast<int>(WorkerCount()));
+
+    // Write next to the final file and rename, so a failed export never leaves a truncated bundle behind.
+    const std::string temp_path = path + ".tmp";
+    std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Could not open " << temp_path << " for writing" << std::endl;
+        return false;
+    }
+
+    std::vector<char> compressed(ZSTD_CStreamOutSize());
+    std::string error;
+    // Feeds `piece` to the compressor and writes whatever it produced. The workers
+    // compress in the background, so this mostly just hands input over.
+    auto compress = [&](std::string_view piece, ZSTD_EndDirective mode) {
+        ZSTD_inBuffer input = {piece.data(), piece.size(), 0};
+        for (;;)
+        {
+            ZSTD_outBuffer output = {compressed.data(), compressed.size(), 0};
+            const size_t remaining = ZSTD_compressStream2(context.get(), &output, &input, mode);
+            if (ZSTD_isError(remaining)) {
+                error = ZSTD_getErrorName(remaining);
+                return;
+            }
+            out.write(compressed.data(), output.pos);
+            export_stats.compressed_bytes += output.pos;
+            const bool done = mode == ZSTD_e_end ? remaining == 0 : input.pos == input.size;
+            if (done) {
+                return;
+            }
+        }
+    };
+
+    StreamContext(selection, options, stats,
+        [&](std::string_view piece) {
+            ZoneScopedN("Compress");
+            if (error.empty()) {
+                compress(piece, ZSTD_e_continue);
+                export_stats.uncompressed_bytes += piece.size();
+            }
+        });
+    if (error.empty()) {
+        compress({}, ZSTD_e_end);
+    }
+    out.close();
+
+    std::error_code ec;
+    if (error.empty() && !out) {
+        error = "write failed";
+    }
+    if (error.empty()) {
+        fs::rename(temp_path, path, ec);
+        if (ec) {
+            error = ec.message();
+        }
+    }
+    if (!error.empty()) {
+        std::cerr << "Could not export context to " << path << ": " << error << std::endl;
+        fs::remove(temp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+// The most a frame header's content size is believed per compressed byte. Real
+// exports stay far below it; a larger claim comes from a damaged or crafted file
+// and is decompressed as a stream instead, which only grows with actual output.
+static constexpr unsigned long long kMaxTrustedRatio = 1024;
+
+static bool DecompressContext(const MappedFile& file, const std::string& path, std::string& text)
+{
+    // Fast path: a single frame that says how big the text is, as the zstd tool
+    // writes them. Decompress it in one call straight into a buffer of exactly that size.
+    const unsigned long long content_size = ZSTD_getFrameContentSize(file.Data(), file.Size());
+    if (content_size == ZSTD_CONTENTSIZE_ERROR) {
+        std::cerr << path << " is not a zstd file" << std::endl;
+        return false;
+    }
+    const bool single_frame = ZSTD_findFrameCompressedSize(file.Data(), file.Size()) == file.Size();
+    const bool plausible_size = content_size / kMaxTrustedRatio <= file.Size();
+    if (single_frame && content_size != ZSTD_CONTENTSIZE_UNKNOWN && plausible_size)
+    {
+        text.resize(static_cast<size_t>(content_size));
+        const size_t written = ZSTD_decompress(text.data(), text.size(), file.Data(), file.Size());
+        if (ZSTD_isError(written) || written != text.size()) {
+            std::cerr << "Could not decompress " << path << ": " << (ZSTD_isError(written) ? ZSTD_getErrorName(written) : "size mismatch") << std::endl;
+            text.clear();
+            return false;
+        }
+        return true;
+    }
+
+    // Exports, which are streamed before their size is known, and concatenated frames;
+    // grow the text as it decompresses.
+    std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> context(ZSTD_createDCtx(), ZSTD_freeDCtx);
+    ZSTD_inBuffer input = {file.Data(), file.Size(), 0};
+    size_t last_result = 0;
+    for (;;)
+    {
+        if (text.capacity() - text.size() < ZSTD_DStreamOutSize()) {
+            text.reserve(std::max(text.capacity() * 2, text.size() + ZSTD_DStreamOutSize()));
+        }
+        const size_t used = text.size();
+        text.resize(text.capacity());
+        ZSTD_outBuffer output = {text.data() + used, text.size() - used, 0};
+        last_result = ZSTD_decompressStream(context.get(), &output, &input);
+        text.resize(used + output.pos);
+        if (ZSTD_isError(last_result)) {
+            std::cerr << "Could not decompress " << path << ": " << ZSTD_getErrorName(last_result) << std::endl;
+            text.clear();
+            return false;
+        }
+        // A full output buffer may mean the decoder still holds data, even with all input read.
+        if (input.pos == input.size && output.pos < output.size) {
+            break;
+        }
+    }
+    if (last_result != 0) {
+        std::cerr << "Could not decompress " << path << ": truncated file" << std::endl;
+        text.clear();
+        return false;
+    }
+    return true;
+}
+
+bool LoadCompressedContext(const std::string& path, std::string& text)
+{
+    ZoneScoped;
+    text.clear();
+    MappedFile file(path);
+    if (!file.IsValid()) {
+        std::cerr << "Could not open " << path << std::endl;
+        return false;
+    }
+    try {
+        return DecompressContext(file, path, text);
+    } catch (const std::bad_alloc&) {
+        std::cerr << "Could not decompress " << path << ": out of memory" << std::endl;
+        text = std::string();
+        return false;
+    }
+}
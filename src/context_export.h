@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "context_generator.h"
+
+struct CompressedExportStats
+{
+    uint64_t uncompressed_bytes = 0;
+    uint64_t compressed_bytes = 0;
+};
+
+// Writes the context for `selection` to `path` as a single zstd frame, compressed
+// on all cores. Files are loaded in bounded batches (see StreamContext) and each
+// piece of text goes straight into the compressor, so neither the files nor the
+// text are ever held in memory as a whole. The total is not known up front, so the
+// frame records a checksum but no content size. Returns false (after logging why)
+// on failure, in which case `path` is left untouched. Takes as long as reading the
+// selection; the app runs it on a worker thread.
+bool ExportCompressedContext(const SelectionMap& selection, const ContextOptions& options, const std::string& path,
+                             ContextStats& stats, CompressedExportStats& export_stats, int level = 3);
+
+// Decompresses a .zst context (from ExportCompressedContext or the zstd tool) into
+// text. When the file is one frame that records its size, this is one allocation
+// and a single decompression call over the mapped file; otherwise the text grows
+// as it is decompressed.
+bool LoadCompressedContext(const std::string& path, std::string& text);
@@ -0,0 +1,554 @@
+#include "context_generator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "xxhash.h"
+
+#include "mapped_file.h"
+#include "metrics.h"
+#include "output_format.h"
+#include "outline.h"
+#include "parallel.h"
+#include "text_diff.h"
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+namespace fs = std::filesystem;
+
+
+struct LoadedFile
+{
+    const std::string* path;
+    std::string content;
+    size_t original_size = 0;   // Before the transform stage
+    uint64_t hash = 0;
+    bool readable = false;
+    int duplicate_of = -1;   // Index of the first file with identical content
+    int same_file_as = -1;   // Another path to the same file, which read it for both
+    // Delta contexts only
+    FileChange change = FileChange::None;
+    bool unchanged = false;  // Same as in the snapshot; left out of the text
+    std::string diff;        // Against the snapshot, when that is shorter than the file
+};
+
+// A file as the transform stage sees it. A hard link or symlink with another
+// extension is transformed as another language, so it must be read on its own.
+struct TransformedFile
+{
+    FileIdentity identity;
+    SourceLanguage language = SourceLanguage::Unknown;
+
+    bool operator==(const TransformedFile& other) const { return identity == other.identity && language == other.language; }
+};
+
+struct TransformedFileHash
+{
+    size_t operator()(const TransformedFile& file) const
+    {
+        return FileIdentityHash()(file.identity) ^ static_cast<size_t>(file.language);
+    }
+};
+
+// What loading remembers from one batch to the next. `files` lists every selected
+// path from the start, but only the batch being assembled holds content; the rest
+// lets later batches still find copies of files an earlier batch already wrote out.
+struct LoadState
+{
+    std::vector<LoadedFile> files;
+    std::unordered_map<TransformedFile, int, TransformedFileHash> reader_by_identity;
+    std::unordered_map<uint64_t, std::vector<int>> first_by_hash;   // Files later ones may duplicate
+    std::unordered_set<std::string_view> present;                   // Delta contexts: paths still selected
+};
+
+// Files read in parallel between two checks of how much a batch holds.
+static constexpr size_t kReadChunk = 256;
+static constexpr uint64_t kWholeSelection = std::numeric_limits<uint64_t>::max();
+
+// The content a file stands for. A second path to a file, or a duplicate, shares it
+// with the file it was read through or copies, unless that file belongs to an
+// earlier batch; its content is gone by now, so this one kept its own.
+static const LoadedFile& ContentOf(const std::vector<LoadedFile>& files, const LoadedFile& file, size_t batch_begin)
+{
+    const int batch = static_cast<int>(batch_begin);
+    if (file.same_file_as >= batch) {
+        return files[file.same_file_as];
+    }
+    return file.duplicate_of >= batch ? files[file.duplicate_of] : file;
+}
+
+static SourceLanguage LanguageOf(const std::string& path, const ContextOptions& options)
+{
+    return options.transform != TransformMode::None ? DetectLanguage(path) : SourceLanguage::Unknown;
+}
+
+static void ApplyTransform(std::string& content, SourceLanguage language, const ContextOptions& options)
+{
+    if (language != SourceLanguage::Unknown)
+    {
+        content = options.transform == TransformMode::Outline ? ExtractOutline(content, language)
+                                                              : StripComments(content, language);
+    }
+}
+
+// Reads and transforms a file of an earlier batch again, to confirm that a later file
+// duplicates it byte for byte. False if it cannot be read any more.
+static bool ReadAgain(const std::string& path, const ContextOptions& options, std::string& content)
+{
+    if (options.source)
+    {
+        if (!options.source->Read(path, content)) {
+            return false;
+        }
+    }
+    else
+    {
+        MappedFile mapped(path);
+        if (!mapped.IsRegularFile()) {
+            return false;
+        }
+        content.assign(mapped.View());
+    }
+    ApplyTransform(content, LanguageOf(path, options), options);
+    return true;
+}
+
+static const ContextSnapshot::File* FindInSnapshot(const ContextOptions& options, const std::string& path)
+{
+    if (!options.since) {
+        return nullptr;
+    }
+    auto found = options.since->files.find(path);
+    return found != options.since->files.end() ? &found->second : nullptr;
+}
+
+// Marks each file of the batch added, modified or unchanged against options.since,
+// and diffs the modified files in parallel when options.delta asks for it.
+static void CompareWithSnapshot(LoadState& state, size_t begin, size_t end, const ContextOptions& options)
+{
+    ZoneScoped;
+    std::vector<LoadedFile>& files = state.files;
+    std::vector<size_t> to_diff;
+    for (size_t i = begin; i < end; ++i)
+    {
+        LoadedFile& file = files[i];
+        if (!file.readable) {
+            continue;
+        }
+        state.present.insert(*file.path);
+        const ContextSnapshot::File* before = FindInSnapshot(options, *file.path);
+        if (!before) {
+            file.change = FileChange::Added;
+            continue;
+        }
+        // The hash settles almost every file; equal hashes are confirmed byte for byte.
+        const LoadedFile& now = ContentOf(files, file, begin);
+        if (before->hash == now.hash && before->content == now.content) {
+            file.unchanged = true;
+            continue;
+        }
+        file.change = FileChange::Modified;
+        if (options.delta == DeltaMode::UnifiedDiffs && file.duplicate_of < 0) {
+            to_diff.push_back(i);
+        }
+    }
+
+    ParallelFor(to_diff.size(), 1, [&](size_t begin, size_t end, size_t) {
+        ZoneScopedN("Diff Files");
+        for (size_t i = begin; i < end; ++i)
+        {
+            LoadedFile& file = files[to_diff[i]];
+            if (!UnifiedDiff(FindInSnapshot(options, *file.path)->content, file.content, file.diff) || file.diff.size() >= file.content.size()) {
+                file.diff.clear(); // Rewritten rather than edited; the whole file says it better
+            }
+        }
+    });
+}
+
+// Appends the files only the snapshot has, as removed ones, after every selected file.
+static void AppendRemoved(LoadState& state, const ContextOptions& options)
+{
+    if (options.delta == DeltaMode::Off || !options.since) {
+        return;
+    }
+    for (const auto& [path, snapshot_file] : options.since->files)
+    {
+        if (state.present.count(path) == 0)
+        {
+            LoadedFile removed;
+            removed.path = &path;
+            removed.readable = true;
+            removed.change = FileChange::Removed;
+            state.files.push_back(std::move(removed));
+        }
+    }
+}
+
+static void ListSelection(const SelectionMap& selection, std::vector<LoadedFile>& files)
+{
+    for (const auto& [path, selected] : selection)
+    {
+        if (selected)
+        {
+            LoadedFile file;
+            file.path = &path;
+            files.push_back(std::move(file));
+        }
+    }
+}
+
+// Reads, transforms and hashes files [chunk_begin, chunk_end) of the batch starting
+// at batch_begin, in parallel.
+static void ReadFiles(LoadState& state, size_t batch_begin, size_t chunk_begin, size_t chunk_end, const ContextOptions& options)
+{
+    // Roots of a workspace can overlap or reach the same files through symlinks; the
+    // identity map makes sure each file is read and transformed once, whichever path wins.
+    std::mutex identity_mutex;
+    ParallelFor(chunk_end - chunk_begin, 4, [&](size_t begin, size_t end, size_t) {
+        ZoneScopedN("Read Files");
+        for (size_t i = chunk_begin + begin; i < chunk_begin + end; ++i)
+        {
+            LoadedFile& file = state.files[i];
+            const SourceLanguage language = LanguageOf(*file.path, options);
+            if (options.source)
+            {
+                // Blobs are inflated right here, on every worker; identical ones still
+                // collapse below, by content.
+                if (!options.source->Read(*file.path, file.content)) {
+                    continue; // Directories, and files the commit does not have
+                }
+                file.readable = true;
+            }
+            else
+            {
+                // The mapping's own fstat tells files from directories, so each path is stat'ed once.
+                MappedFile mapped(*file.path);
+                if (!mapped.IsRegularFile()) {
+                    continue; // Directories are in the selection too; they have no content of their own.
+                }
+                file.readable = true;
+                {
+                    std::lock_guard<std::mutex> lock(identity_mutex);
+                    auto [reader, inserted] = state.reader_by_identity.emplace(TransformedFile{mapped.Identity(), language}, static_cast<int>(i));
+                    if (!inserted)
+                    {
+                        file.same_file_as = reader->second;
+                        // A reader of an earlier batch has dropped its content; read it again.
+                        if (reader->second >= static_cast<int>(batch_begin)) {
+                            continue;
+                        }
+                    }
+                }
+                file.content.assign(mapped.View());
+            }
+            file.original_size = file.content.size();
+            ApplyTransform(file.content, language, options);
+            // Hash after the transform, so copies that only differ in comments collapse
+            // too. Snapshots keep the hash to tell changed files apart quickly.
+            file.hash = XXH3_64bits(file.content.data(), file.content.size());
+        }
+    });
+}
+
+// Loads the batch of files from `begin` on: reads them until it holds about
+// max_bytes of content, then deduplicates them, against earlier batches too, and
+// compares them with the snapshot for delta contexts. Returns where the batch ends.
+static size_t LoadBatch(LoadState& state, size_t begin, uint64_t max_bytes, const ContextOptions& options)
+{
+    ZoneScoped;
+    std::vector<LoadedFile>& files = state.files;
+    const int batch = static_cast<int>(begin);
+    size_t end = begin;
+    uint64_t loaded = 0;
+    // Without a limit there is nothing to check in between; read everything at once.
+    const size_t chunk = max_bytes == kWholeSelection ? files.size() : kReadChunk;
+    while (end < files.size() && loaded < max_bytes)
+    {
+        const size_t chunk_end = std::min(files.size(), end + chunk);
+        ReadFiles(state, begin, end, chunk_end, options);
+        for (size_t i = end; i < chunk_end; ++i) {
+            loaded += files[i].content.size();
+        }
+        end = chunk_end;
+    }
+
+    // --- Give each shared file's content to its first path ---
+    // Whichever worker got there first read it; the output should cite the path that
+    // comes first, like content duplicates do.
+    std::unordered_map<int, int> first_path_of_reader;
+    for (int i = batch; i < static_cast<int>(end); ++i)
+    {
+        if (files[i].same_file_as >= batch) {
+            first_path_of_reader.emplace(files[i].same_file_as, i); // Ascending, so the first emplace is the lowest
+        }
+    }
+    for (const auto& [reader, first] : first_path_of_reader)
+    {
+        if (first < reader)
+        {
+            LoadedFile& to = files[first];
+            LoadedFile& from = files[reader];
+            to.content = std::move(from.content);
+            to.original_size = from.original_size;
+            to.hash = from.hash;
+            to.same_file_as = -1;
+            from.content.clear();
+            from.original_size = 0;
+            from.same_file_as = first;
+        }
+    }
+    for (size_t i = begin; i < end; ++i)
+    {
+        LoadedFile& file = files[i];
+        if (file.same_file_as < 0) {
+            continue;
+        }
+        auto moved = first_path_of_reader.find(file.same_file_as);
+        if (moved != first_path_of_reader.end() && moved->second < moved->first) {
+            file.same_file_as = moved->second;
+        }
+        if (options.deduplicate) {
+            file.duplicate_of = file.same_file_as;
+            file.original_size = 0; // Counted once, for the path it was first read through
+        } else if (file.same_file_as >= batch) {
+            file.content = files[file.same_file_as].content; // Still read only once
+            file.original_size = files[file.same_file_as].original_size;
+            file.hash = files[file.same_file_as].hash;
+        }
+    }
+
+    // --- Find duplicates, keeping the first occurrence in path order ---
+    if (options.deduplicate)
+    {
+        ZoneScopedN("Deduplicate");
+        for (int i = batch; i < static_cast<int>(end); ++i)
+        {
+            LoadedFile& file = files[i];
+            if (!file.readable || file.content.empty() || file.duplicate_of >= 0) {
+                continue;
+            }
+            std::vector<int>& candidates = state.first_by_hash[file.hash];
+            for (int candidate : candidates)
+            {
+                // Confirm byte for byte; a 64-bit collision must never drop real content.
+                // An earlier batch's file is read again for that.
+                std::string earlier;
+                const bool same = candidate >= batch ? files[candidate].content == file.content
+                                                     : ReadAgain(*files[candidate].path, options, earlier) && earlier == file.content;
+                if (same) {
+                    file.duplicate_of = candidate;
+                    break;
+                }
+            }
+            if (file.duplicate_of < 0) {
+                candidates.push_back(i);
+            }
+        }
+        // A second path to a file points at the path that read it, which may itself
+        // have turned out to duplicate an earlier file; always cite the first one.
+        for (size_t i = begin; i < end; ++i)
+        {
+            LoadedFile& file = files[i];
+            while (file.duplicate_of >= 0 && files[file.duplicate_of].duplicate_of >= 0) {
+                file.duplicate_of = files[file.duplicate_of].duplicate_of;
+            }
+        }
+    }
+
+    if (options.delta != DeltaMode::Off) {
+        CompareWithSnapshot(state, begin, end, options);
+    }
+    return end;
+}
+
+static FormattedFile Formatted(const std::vector<LoadedFile>& files, const LoadedFile& file)
+{
+    FormattedFile entry{*file.path, file.content};
+    entry.change = file.change;
+    if (file.duplicate_of >= 0) {
+        entry.content = {};
+        entry.duplicate_of = files[file.duplicate_of].path;
+    } else if (!file.diff.empty()) {
+        entry.content = file.diff;
+        entry.is_diff = true;
+    }
+    return entry;
+}
+
+// The exact size of the text for every file, prologue and epilogue included.
+static size_t MeasureContext(const std::vector<LoadedFile>& files, const ContextFormatter& formatter)
+{
+    size_t total_size = formatter.Prologue().size() + formatter.Epilogue().size();
+    for (const auto& file : files)
+    {
+        if (file.readable && !file.unchanged) {
+            total_size += formatter.Measure(Formatted(files, file));
+        }
+    }
+    return total_size;
+}
+
+// Lays files [begin, end) out with the formatter, after whatever `out` holds.
+// flush(out) runs after every file and may hand off and clear what has accumulated.
+template <typename Flush>
+static void Assemble(const std::vector<LoadedFile>& files, size_t begin, size_t end, const ContextFormatter& formatter, std::string& out,
+                     ContextStats& stats, Flush&& flush)
+{
+    ZoneScopedN("Assemble");
+    for (size_t i = begin; i < end; ++i)
+    {
+        const LoadedFile& file = files[i];
+        if (!file.readable) continue;
+        switch (file.change)
+        {
+        case FileChange::Added: stats.added_count++; break;
+        case FileChange::Modified: stats.modified_count++; break;
+        case FileChange::Removed: stats.removed_count++; break;
+        case FileChange::None: break;
+        }
+        if (file.unchanged) {
+            stats.unchanged_count++;
+            stats.bytes_read += file.original_size;
+            continue;
+        }
+        const FormattedFile entry = Formatted(files, file);
+        formatter.Write(entry, out);
+        flush(out);
+        stats.file_count++;
+        stats.bytes_read += file.original_size;
+        if (file.content.size() < file.original_size)
+        {
+            FileTokenSavings saving;
+            saving.path = *file.path;
+            saving.original_tokens = static_cast<int>(file.original_size / 4);
+            saving.final_tokens = static_cast<int>(file.content.size() / 4);
+            stats.tokens_saved += saving.original_tokens - saving.final_tokens;
+            stats.savings.push_back(std::move(saving));
+        }
+        if (file.duplicate_of >= 0)
+        {
+            stats.token_count += (files[file.duplicate_of].path->size() + 15) / 4; // "(identical to " path ")"
+            stats.duplicate_count++;
+        }
+        else
+        {
+            stats.token_count += entry.content.length() / 4; // Simple token approximation
+        }
+    }
+}
+
+static void FinishStats(ContextStats& stats)
+{
+    std::sort(stats.savings.begin(), stats.savings.end(), [](const FileTokenSavings& a, const FileTokenSavings& b) {
+        return a.original_tokens - a.final_tokens > b.original_tokens - b.final_tokens;
+    });
+    AddMetric(Metric::GenerateBytesRead, stats.bytes_read);
+    AddMetric(Metric::GenerateFiles, static_cast<uint64_t>(stats.file_count));
+}
+
+// Done with the text of files [begin, end), so every content moves into the snapshot
+// except those another file of the batch still has to be copied from.
+static void TakeSnapshot(std::vector<LoadedFile>& files, size_t begin, size_t end, ContextSnapshot& snapshot)
+{
+    ZoneScoped;
+    for (size_t i = begin; i < end; ++i)
+    {
+        const LoadedFile& file = files[i];
+        const LoadedFile& content = ContentOf(files, file, begin);
+        if (file.readable && file.change != FileChange::Removed && &content != &file) {
+            snapshot.files[*file.path] = {content.hash, content.content};
+        }
+    }
+    for (size_t i = begin; i < end; ++i)
+    {
+        LoadedFile& file = files[i];
+        if (file.readable && file.change != FileChange::Removed && &ContentOf(files, file, begin) == &file) {
+            snapshot.files[*file.path] = {file.hash, std::move(file.content)};
+        }
+    }
+}
+
+void GenerateContext(const SelectionMap& selection, const ContextOptions& options, std::string& aggregated_text, ContextStats& stats,
+                     ContextSnapshot* snapshot)
+{
+    ZoneScoped;
+    ScopedMetricTimer generate_timer(Metric::GenerateNanoseconds);
+    aggregated_text.clear();
+    stats = {};
+
+    // The whole text is wanted anyway, so everything loads as one batch.
+    LoadState state;
+    ListSelection(selection, state.files);
+    const size_t selected = LoadBatch(state, 0, kWholeSelection, options);
+    AppendRemoved(state, options);
+
+    // Sized exactly by the formatter, so the text is built with one allocation.
+    const std::unique_ptr<ContextFormatter> formatter = MakeFormatter(options.format);
+    aggregated_text.reserve(MeasureContext(state.files, *formatter));
+    aggregated_text += formatter->Prologue();
+    Assemble(state.files, 0, state.files.size(), *formatter, aggregated_text, stats, [](std::string&) {});
+    aggregated_text += formatter->Epilogue();
+    FinishStats(stats);
+    if (snapshot)
+    {
+        snapshot->files.clear();
+        TakeSnapshot(state.files, 0, selected, *snapshot);
+    }
+}
+
+void StreamContext(const SelectionMap& selection, const ContextOptions& options, ContextStats& stats,
+                   const std::function<void(std::string_view piece)>& write,
+                   size_t piece_size, ContextSnapshot* snapshot)
+{
+    ZoneScoped;
+    ScopedMetricTimer generate_timer(Metric::GenerateNanoseconds);
+    stats = {};
+    if (snapshot) {
+        snapshot->files.clear();
+    }
+
+    const std::unique_ptr<ContextFormatter> formatter = MakeFormatter(options.format);
+    std::string piece;
+    piece.reserve(piece_size);
+    auto flush = [&](std::string& out) {
+        if (out.size() >= piece_size) {
+            write(out);
+            out.clear();
+        }
+    };
+
+    LoadState state;
+    ListSelection(selection, state.files);
+    const size_t selected = state.files.size();
+    piece += formatter->Prologue();
+    for (size_t begin = 0; begin < selected;)
+    {
+        const size_t end = LoadBatch(state, begin, std::max<uint64_t>(options.batch_bytes, 1), options);
+        Assemble(state.files, begin, end, *formatter, piece, stats, flush);
+        if (snapshot) {
+            TakeSnapshot(state.files, begin, end, *snapshot);
+        }
+        // Written out; later batches only need the paths and hashes.
+        for (size_t i = begin; i < end; ++i)
+        {
+            state.files[i].content = std::string();
+            state.files[i].diff = std::string();
+        }
+        begin = end;
+    }
+    AppendRemoved(state, options);
+    Assemble(state.files, selected, state.files.size(), *formatter, piece, stats, flush);
+    piece += formatter->Epilogue();
+    if (!piece.empty()) {
+        write(piece);
+    }
+    FinishStats(stats);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "context_snapshot.h"
+#include "git_commit_source.h"
+#include "output_format.h"
+#include "selection.h"
+#include "source_transform.h"
+
+// What goes into a context taken against a snapshot (ContextOptions::since).
+enum class DeltaMode
+{
+    Off,            // Every selected file, whatever the snapshot holds
+    ChangedFiles,   // Added and modified files in full, removed ones by path only
+    UnifiedDiffs    // The same, but modified files as unified diffs when that is shorter
+};
+
+struct ContextOptions
+{
+    // Emit files with identical content only once; later copies become a one-line reference.
+    bool deduplicate = true;
+    // Applied per file, in parallel, to languages DetectLanguage recognises. Other files stay verbatim.
+    TransformMode transform = TransformMode::None;
+    OutputFormat format = OutputFormat::Plain;
+    // Compared by path, content hash and then byte for byte. Without a snapshot a
+    // delta context lists every file as added. Compare with the same transform the
+    // snapshot was taken with, or every transformed file shows up as modified.
+    DeltaMode delta = DeltaMode::Off;
+    const ContextSnapshot* since = nullptr;
+    // Read every file as this commit has it instead of from the disk. Selected files
+    // the commit does not have are left out, like unreadable ones.
+    const GitCommitSource* source = nullptr;
+    // StreamContext only: about how much file content it loads, and holds, at a time.
+    uint64_t batch_bytes = 64ull << 20;
+};
+
+struct FileTokenSavings
+{
+    std::string path;
+    int original_tokens = 0;
+    int final_tokens = 0;
+};
+
+struct ContextStats
+{
+    int file_count = 0;
+    int token_count = 0;
+    int duplicate_count = 0;
+    uint64_t bytes_read = 0;
+    int tokens_saved = 0;                    // By the transform stage
+    std::vector<FileTokenSavings> savings;   // Files the transform shrank, biggest saving first
+    // Delta contexts only; unchanged files are left out of the text and of file_count.
+    int added_count = 0;
+    int modified_count = 0;
+    int removed_count = 0;
+    int unchanged_count = 0;
+};
+
+// Concatenates every selected regular file into aggregated_text, laid out by
+// options.format (a "--- path ---" header per file by default). Files are read and
+// hashed in parallel; the output is then assembled in selection (path) order with
+// a single allocation, sized exactly by the formatter beforehand.
+// With `snapshot`, it is replaced by what the selection holds now, whatever
+// options.delta says, so the next delta is taken against this context. It must not
+// be options.since.
+void GenerateContext(const SelectionMap& selection, const ContextOptions& options, std::string& aggregated_text, ContextStats& stats,
+                     ContextSnapshot* snapshot = nullptr);
+
+// Produces the same text as GenerateContext without ever holding all of it. Files
+// are loaded in batches of about options.batch_bytes; each batch is deduplicated
+// (against earlier batches too, rereading a file to confirm a match), compared with
+// the snapshot, handed to `write` in pieces of roughly piece_size bytes (a single
+// large file can make one piece bigger) and dropped before the next one is read.
+// `snapshot` works as it does for GenerateContext, and so does hold every file.
+void StreamContext(const SelectionMap& selection, const ContextOptions& options, ContextStats& stats,
+                   const std::function<void(std::string_view piece)>& write,
+                   size_t piece_size = 1 << 20, ContextSnapshot* snapshot = nullptr);
@@ -0,0 +1,651 @@
+#include "context_server.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <afunix.h>
+#else
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "nlohmann/json.hpp"
+
+#include "context_generator.h"
+#include "git_changes.h"
+#include "projects.h"
+#include "scan_index.h"
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+using json = nlohmann::json;
+
+// --- Protocol ---
+// Every request is one JSON object on one line, and so is every line of the answer.
+// The request's "id" is echoed in each line answering it.
+//
+//   {"id": 1, "method": "ping"}
+//       -> {"id": 1, "done": true}
+//   {"id": 2, "method": "projects"}
+//       -> {"id": 2, "projects": [{"name": "...", "root_paths": ["..."]}], "done": true}
+//   {"id": 3, "method": "context", "project": "X"}
+//   {"id": 4, "method": "context", "root": "/src/app", "paths": ["src", "README.md"],
+//    "deduplicate": true, "transform": "none" | "strip" | "outline",
+//    "format": "plain" | "markdown" | "xml" | "jsonl",
+//    "delta": "none" | "files" | "diff", "since": "/path/to/snapshot", "snapshot": "/path/to/snapshot"}
+//   {"id": 5, "method": "context", "root": "/src/app", "changes": {"worktree": true, "staged": true, "since": "main"}}
+//   {"id": 6, "method": "context", "root": "/src/app", "paths": ["src"], "revision": "v1.2"}
+//       -> {"id": 3, "chunk": "--- /src/app/src/a.cpp ---\n..."}   (any number, in order)
+//          {"id": 3, "done": true, "files": 12, "tokens": 3400, "bytes": 13600, "duplicates": 0}
+//
+// "delta" sends only what changed since the snapshot file "since" (see DeltaMode);
+// the answer then also counts "added", "modified", "removed" and "unchanged" files.
+// "snapshot" saves a snapshot of this context there, for the next delta request.
+//
+// A project request uses the project's saved selection, exactly like the app does.
+// "paths" are relative to "root"; directories select every file below them, using
+// the warm tree for that root. "changes" instead selects the tracked files under
+// "root" that git would list as changed (see GitChangesOptions; each key is
+// optional). With "revision", every file is read as that commit has it, and "paths"
+// select what the commit has below them rather than what is on disk. Anything that
+// fails answers {"id": ..., "error": "..."}.
+
+static constexpr size_t kChunkSize = 64 * 1024;
+static constexpr size_t kMaxRequestSize = 1024 * 1024;
+// Cached trees older than this are revalidated before use. Revalidation reuses every
+// unchanged directory's listing, so it costs about one stat per directory.
+static constexpr auto kTreeMaxAge = std::chrono::seconds(2);
+
+#ifdef _WIN32
+using SocketHandle = SOCKET;
+static const SocketHandle kInvalidSocket = INVALID_SOCKET;
+static void CloseSocket(SocketHandle socket) { closesocket(socket); }
+static int PollSocket(pollfd* fd, int timeout_ms) { return WSAPoll(fd, 1, timeout_ms); }
+static const int kShutdownBoth = SD_BOTH;
+static const int kSendFlags = 0;
+#else
+using SocketHandle = int;
+static const SocketHandle kInvalidSocket = -1;
+static void CloseSocket(SocketHandle socket) { close(socket); }
+static int PollSocket(pollfd* fd, int timeout_ms) { return poll(fd, 1, timeout_ms); }
+static const int kShutdownBoth = SHUT_RDWR;
+// A client hanging up must not kill the app with SIGPIPE. Where send() has no flag
+// for that (macOS), AcceptLoop sets SO_NOSIGPIPE on every client socket instead.
+#ifdef MSG_NOSIGNAL
+static const int kSendFlags = MSG_NOSIGNAL;
+#else
+static const int kSendFlags = 0;
+#endif
+#endif
+
+static SocketHandle ToSocket(intptr_t handle) { return static_cast<SocketHandle>(handle); }
+static intptr_t FromSocket(SocketHandle socket) { return static_cast<intptr_t>(socket); }
+
+
+std::string DefaultServerSocketPath()
+{
+    std::error_code ec;
+#ifdef _WIN32
+    return (fs::temp_directory_path(ec) / "ai-context-builder.sock").string();
+#else
+    const char* runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir && *runtime_dir) {
+        return (fs::path(runtime_dir) / "ai-context-builder.sock").string();
+    }
+    return (fs::temp_directory_path(ec) / ("ai-context-builder-" + std::to_string(getuid()) + ".sock")).string();
+#endif
+}
+
+static bool MakeAddress(const std::string& path, sockaddr_un& address)
+{
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+static bool SendAll(SocketHandle socket, const char* data, size_t size)
+{
+    while (size > 0)
+    {
+        const auto sent = send(socket, data, static_cast<int>(std::min<size_t>(size, 1 << 30)), kSendFlags);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+static bool SendLine(SocketHandle socket, const json& message)
+{
+    // File contents are not guaranteed to be UTF-8; replace invalid bytes rather than throw.
+    std::string line = message.dump(-1, ' ', false, json::error_handler_t::replace);
+    line += '\n';
+    return SendAll(socket, line.data(), line.size());
+}
+
+static bool SendError(SocketHandle socket, const json& id, const std::string& message)
+{
+    return SendLine(socket, {{"id", id}, {"error", message}});
+}
+
+// Sends a piece of a context as "chunk" lines of about kChunkSize bytes, never
+// splitting a UTF-8 sequence. Pieces end between files, so neither do the chunks.
+static bool SendChunks(SocketHandle socket, const json& id, std::string_view text)
+{
+    ZoneScopedN("Stream Context");
+    while (!text.empty())
+    {
+        size_t size = std::min(kChunkSize, text.size());
+        while (size < text.size() && size > 0 && (static_cast<unsigned char>(text[size]) & 0xC0) == 0x80) {
+            --size;
+        }
+        if (size == 0) {
+            size = std::min(kChunkSize, text.size()); // Not UTF-8 at all; the encoder replaces it anyway.
+        }
+        if (!SendLine(socket, {{"id", id}, {"chunk", text.substr(0, size)}})) {
+            return false;
+        }
+        text.remove_prefix(size);
+    }
+    return true;
+}
+
+
+// Selects every file at or below `index`. `path` is the node's key, built the same
+// way the tree view builds it, so headers match what the app would generate.
+static void SelectFiles(const FileTree& tree, uint32_t index, std::string& path, SelectionMap& selection)
+{
+    const FileNode& node = tree.nodes[index];
+    if (!node.is_directory) {
+        selection[path] = true;
+        return;
+    }
+    for (uint32_t child = node.first_child; child < node.first_child + node.child_count; ++child)
+    {
+        const size_t length = path.size();
+        AppendPathComponent(path, tree.Name(child));
+        SelectFiles(tree, child, path, selection);
+        path.resize(length);
+    }
+}
+
+
+ContextServer::~ContextServer()
+{
+    Stop();
+}
+
+bool ContextServer::Start(const std::string& path, size_t worker_count)
+{
+    Stop();
+
+#ifdef _WIN32
+    static const bool winsock_ready = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    if (!winsock_ready) {
+        std::cerr << "Context server: Winsock is not available" << std::endl;
+        return false;
+    }
+#endif
+
+    sockaddr_un address;
+    if (!MakeAddress(path, address)) {
+        std::cerr << "Context server: socket path is empty or too long: " << path << std::endl;
+        return false;
+    }
+
+    std::error_code ec;
+    if (fs::exists(path, ec))
+    {
+        // Either another instance is listening there, or a crashed one left the file behind.
+        SocketHandle probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        const bool in_use = probe != kInvalidSocket && connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+        if (probe != kInvalidSocket) {
+            CloseSocket(probe);
+        }
+        if (in_use) {
+            std::cerr << "Context server: another instance is already listening on " << path << std::endl;
+            return false;
+        }
+        fs::remove(path, ec);
+    }
+
+    SocketHandle listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener == kInvalidSocket) {
+        std::cerr << "Context server: cannot create a socket" << std::endl;
+        return false;
+    }
+#ifndef _WIN32
+    // Contexts contain source code; only our own user may ask for them. The socket
+    // file is created by bind() itself, so it must get its permissions right there:
+    // a chmod afterwards leaves a window in which anyone could connect.
+    const mode_t previous_mask = umask(0077);
+#endif
+    const bool bound = bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+#ifndef _WIN32
+    umask(previous_mask);
+#endif
+    if (!bound) {
+        std::cerr << "Context server: cannot bind " << path << std::endl;
+        CloseSocket(listener);
+        return false;
+    }
+    if (listen(listener, 16) != 0) {
+        std::cerr << "Context server: cannot listen on " << path << std::endl;
+        CloseSocket(listener);
+        fs::remove(path, ec);
+        return false;
+    }
+
+    socket_path = path;
+    listen_socket = FromSocket(listener);
+    stopping = false;
+    for (size_t i = 0; i < std::max<size_t>(worker_count, 1); ++i) {
+        workers.emplace_back(&ContextServer::WorkerLoop, this);
+    }
+    accept_thread = std::thread(&ContextServer::AcceptLoop, this);
+    return true;
+}
+
+void ContextServer::Stop()
+{
+    if (!accept_thread.joinable()) {
+        return;
+    }
+    stopping = true;
+    accept_thread.join();
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        for (intptr_t client : active_clients) {
+            shutdown(ToSocket(client), kShutdownBoth); // The worker closes it once its recv returns.
+        }
+        for (intptr_t client : pending_clients) {
+            CloseSocket(ToSocket(client));
+        }
+        pending_clients.clear();
+    }
+    queue_ready.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+
+    CloseSocket(ToSocket(listen_socket));
+    listen_socket = -1;
+    std::error_code ec;
+    fs::remove(socket_path, ec);
+}
+
+// The key of a root's cached tree. Every spelling of one directory ("/a/b", "/a/b/",
+// a symlink to it) resolves to the same key, and so shares one tree.
+static std::string CanonicalRoot(const std::string& root_path)
+{
+    std::error_code ec;
+    const fs::path resolved = fs::weakly_canonical(root_path, ec);
+    return ec ? root_path : resolved.string();
+}
+
+void ContextServer::ShareTree(std::shared_ptr<const FileTree> tree)
+{
+    if (!tree) {
+        return;
+    }
+    const std::string key = CanonicalRoot(tree->root_path);
+    if (tree->root_path != key)
+    {
+        // Context headers start with the root; they must read the same whichever
+        // tree serves the request, the UI's or one the server scanned itself.
+        auto canonical = std::make_shared<FileTree>(*tree);
+        canonical->root_path = key;
+        tree = std::move(canonical);
+    }
+    std::lock_guard<std::mutex> lock(trees_mutex);
+    CachedTree& cached = trees[key];
+    cached.tree = std::move(tree);
+    cached.checked = std::chrono::steady_clock::now();
+}
+
+void ContextServer::AcceptLoop()
+{
+    // Polling with a timeout lets Stop() end the loop without relying on close()
+    // waking a blocked accept(), which not every platform does.
+    while (!stopping)
+    {
+        pollfd fd = {};
+        fd.fd = ToSocket(listen_socket);
+        fd.events = POLLIN;
+        if (PollSocket(&fd, 200) <= 0) {
+            continue;
+        }
+        SocketHandle client = accept(ToSocket(listen_socket), nullptr, nullptr);
+        if (client == kInvalidSocket) {
+            continue;
+        }
+#if !defined(_WIN32) && !defined(MSG_NOSIGNAL) && defined(SO_NOSIGPIPE)
+        const int no_sigpipe = 1;
+        setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            pending_clients.push_back(FromSocket(client));
+        }
+        queue_ready.notify_one();
+    }
+}
+
+void ContextServer::WorkerLoop()
+{
+    for (;;)
+    {
+        intptr_t client;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_ready.wait(lock, [&] { return stopping || !pending_clients.empty(); });
+            if (stopping) {
+                return;
+            }
+            client = pending_clients.front();
+            pending_clients.pop_front();
+            active_clients.push_back(client);
+        }
+
+        Serve(client);
+
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            active_clients.erase(std::find(active_clients.begin(), active_clients.end(), client));
+        }
+        CloseSocket(ToSocket(client));
+    }
+}
+
+// Answers one connection's requests in order until the client hangs up.
+void ContextServer::Serve(intptr_t client)
+{
+    std::string buffer;
+    char incoming[4096];
+    while (!stopping)
+    {
+        const auto received = recv(ToSocket(client), incoming, sizeof(incoming), 0);
+        if (received <= 0) {
+            return;
+        }
+        buffer.append(incoming, static_cast<size_t>(received));
+
+        size_t line_start = 0;
+        for (size_t newline; (newline = buffer.find('\n', line_start)) != std::string::npos; line_start = newline + 1)
+        {
+            if (!HandleRequest(client, buffer.substr(line_start, newline - line_start))) {
+                return;
+            }
+        }
+        buffer.erase(0, line_start);
+        if (buffer.size() > kMaxRequestSize) {
+            SendError(ToSocket(client), nullptr, "request line too long");
+            return;
+        }
+    }
+}
+
+// Returns false when the connection should be dropped.
+bool ContextServer::HandleRequest(intptr_t client, const std::string& line)
+{
+    ZoneScopedN("Server Request");
+    const SocketHandle socket = ToSocket(client);
+    if (line.find_first_not_of(" \t\r") == std::string::npos) {
+        return true;
+    }
+
+    json request = json::parse(line, nullptr, false);
+    if (request.is_discarded() || !request.is_object()) {
+        return SendError(socket, nullptr, "request is not a JSON object");
+    }
+    const json id = request.value("id", json());
+    const std::string method = request.value("method", "");
+
+    try {
+        if (method == "ping")
+        {
+            return SendLine(socket, {{"id", id}, {"done", true}});
+        }
+        if (method == "projects")
+        {
+            json list = json::array();
+            for (const auto& project : LoadProjects()) {
+                list.push_back({{"name", project.name}, {"root_paths", project.root_paths}});
+            }
+            return SendLine(socket, {{"id", id}, {"projects", list}, {"done", true}});
+        }
+        if (method != "context") {
+            return SendError(socket, id, "unknown method: " + method);
+        }
+
+        const std::string revision = request.value("revision", "");
+        GitCommitSource source;
+        std::string source_error;
+        SelectionMap selection;
+        if (request.contains("project"))
+        {
+            const std::string name = request["project"].get<std::string>();
+            const std::vector<Project> projects = LoadProjects();
+            auto project = std::find_if(projects.begin(), projects.end(), [&](const Project& p) { return p.name == name; });
+            if (project == projects.end()) {
+                return SendError(socket, id, "no such project: " + name);
+            }
+            if (!revision.empty() && !source.Open(project->root_paths, revision, source_error)) {
+                return SendError(socket, id, source_error);
+            }
+            for (const auto& path : project->selected_paths) {
+                selection[path] = true;
+            }
+        }
+        else
+        {
+            const std::string root = request.value("root", "");
+            if (root.empty()) {
+                return SendError(socket, id, "a context request needs a \"project\" or a \"root\"");
+            }
+            if (!revision.empty() && !source.Open({root}, revision, source_error)) {
+                return SendError(socket, id, source_error);
+            }
+            std::shared_ptr<const FileTree> tree;
+            if (request.contains("changes"))
+            {
+                tree = TreeFor(root);
+                const json& changes = request["changes"];
+                GitChangesOptions git_options;
+                git_options.worktree = changes.value("worktree", git_options.worktree);
+                git_options.staged = changes.value("staged", git_options.staged);
+                git_options.since = changes.value("since", "");
+                const GitChangesResult changed = FindGitChanges(*tree, git_options);
+                if (!changed.error.empty()) {
+                    return SendError(socket, id, changed.error);
+                }
+                for (uint32_t node : changed.nodes) {
+                    selection[tree->Path(node).string()] = true;
+                }
+            }
+            const json paths = request.value("paths", request.contains("changes") ? json::array() : json::array({""}));
+            for (const auto& relative : paths)
+            {
+                const std::string relative_path = relative.get<std::string>();
+                if (!revision.empty())
+                {
+                    // Whatever the commit has there, whether or not it is still on disk.
+                    std::string path = root;
+                    for (const auto& part : fs::path(relative_path)) {
+                        if (!part.empty() && part != ".") AppendPathComponent(path, part.string());
+                    }
+                    std::vector<std::string> files;
+                    if (!source.ListFiles(path, files)) {
+                        return SendError(socket, id, "not in " + revision + ": " + relative_path);
+                    }
+                    for (const auto& file : files) {
+                        selection[file] = true;
+                    }
+                    continue;
+                }
+                if (!tree) {
+                    tree = TreeFor(root);
+                }
+                const uint32_t node = tree->FindPath(relative_path);
+                if (node == kInvalidNode) {
+                    return SendError(socket, id, "not found under " + root + ": " + relative_path);
+                }
+                std::string path = tree->Path(node).string();
+                SelectFiles(*tree, node, path, selection);
+            }
+        }
+
+        ContextOptions options;
+        options.deduplicate = request.value("deduplicate", options.deduplicate);
+        const std::string transform = request.value("transform", "none");
+        if (transform == "strip") {
+            options.transform = TransformMode::StripComments;
+        } else if (transform == "outline") {
+            options.transform = TransformMode::Outline;
+        } else if (transform != "none") {
+            return SendError(socket, id, "unknown transform: " + transform);
+        }
+        const std::string format = request.value("format", "plain");
+        if (format == "markdown") {
+            options.format = OutputFormat::Markdown;
+        } else if (format == "xml") {
+            options.format = OutputFormat::Xml;
+        } else if (format == "jsonl") {
+            options.format = OutputFormat::JsonLines;
+        } else if (format != "plain") {
+            return SendError(socket, id, "unknown format: " + format);
+        }
+        const std::string delta = request.value("delta", "none");
+        if (delta == "files") {
+            options.delta = DeltaMode::ChangedFiles;
+        } else if (delta == "diff") {
+            options.delta = DeltaMode::UnifiedDiffs;
+        } else if (delta != "none") {
+            return SendError(socket, id, "unknown delta: " + delta);
+        }
+        ContextSnapshot since;
+        if (options.delta != DeltaMode::Off)
+        {
+            const std::string since_path = request.value("since", "");
+            if (!since_path.empty() && !LoadContextSnapshot(since_path, since)) {
+                return SendError(socket, id, "cannot read snapshot: " + since_path);
+            }
+            options.since = &since;
+        }
+        const std::string snapshot_path = request.value("snapshot", "");
+        if (!revision.empty()) {
+            options.source = &source;
+        }
+
+        // Each piece goes out as soon as it is assembled; once the client is gone the
+        // rest is only generated, not sent.
+        bool sent = true;
+        ContextStats stats;
+        ContextSnapshot snapshot;
+        StreamContext(selection, options, stats,
+            [&](std::string_view piece) { sent = sent && SendChunks(socket, id, piece); },
+            kChunkSize, snapshot_path.empty() ? nullptr : &snapshot);
+        if (!sent) {
+            return false;
+        }
+        if (!snapshot_path.empty() && !SaveContextSnapshot(snapshot, snapshot_path)) {
+            return SendError(socket, id, "cannot write snapshot: " + snapshot_path);
+        }
+        json done = {
+            {"id", id},
+            {"done", true},
+            {"files", stats.file_count},
+            {"tokens", stats.token_count},
+            {"bytes", stats.bytes_read},
+            {"duplicates", stats.duplicate_count}
+        };
+        if (options.delta != DeltaMode::Off)
+        {
+            done["added"] = stats.added_count;
+            done["modified"] = stats.modified_count;
+            done["removed"] = stats.removed_count;
+            done["unchanged"] = stats.unchanged_count;
+        }
+        return SendLine(socket, done);
+    } catch (const std::exception& e) {
+        // Mostly json type errors from malformed fields; the connection stays usable.
+        return SendError(socket, id, e.what());
+    }
+}
+
+// The cached tree for root_path, revalidated if it is getting old, or a fresh scan
+// (seeded from the scan index when there is one) the first time a root is asked for.
+// Requests arriving while a root is being scanned wait for that scan rather than
+// starting their own.
+std::shared_ptr<const FileTree> ContextServer::TreeFor(const std::string& root_path)
+{
+    ZoneScoped;
+    const std::string key = CanonicalRoot(root_path);
+    std::shared_ptr<const FileTree> previous;
+    std::shared_future<std::shared_ptr<const FileTree>> in_flight;
+    std::promise<std::shared_ptr<const FileTree>> scanned;
+    {
+        std::lock_guard<std::mutex> lock(trees_mutex);
+        CachedTree& cached = trees[key];
+        if (cached.tree && std::chrono::steady_clock::now() - cached.checked < kTreeMaxAge) {
+            return cached.tree;
+        }
+        in_flight = cached.scanning;
+        if (!in_flight.valid()) {
+            previous = cached.tree;
+            cached.scanning = scanned.get_future().share();
+        }
+    }
+    if (in_flight.valid()) {
+        return in_flight.get();
+    }
+    if (!previous) {
+        previous = LoadScanIndex(key);
+    }
+    if (!previous && key != root_path) {
+        previous = LoadScanIndex(root_path);
+    }
+
+    std::shared_ptr<const FileTree> tree;
+    try {
+        tree = std::make_shared<const FileTree>(ScanFileTree(key, &stopping, previous.get()));
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(trees_mutex);
+            trees[key].scanning = {};
+        }
+        scanned.set_exception(std::current_exception());
+        throw;
+    }
+    {
+        std::lock_guard<std::mutex> lock(trees_mutex);
+        CachedTree& cached = trees[key];
+        cached.scanning = {};
+        if (!stopping) { // A cancelled scan is partial; never cache it.
+            cached.tree = tree;
+            cached.checked = std::chrono::steady_clock::now();
+        }
+    }
+    scanned.set_value(tree);
+    return tree;
+}
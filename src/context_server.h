@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "file_tree.h"
+
+// Where the app and the headless server listen unless told otherwise:
+// $XDG_RUNTIME_DIR/ai-context-builder.sock, or a per-user name in the temp directory.
+std::string DefaultServerSocketPath();
+
+// Answers context requests from editor plugins and scripts over a Unix domain
+// socket (AF_UNIX; Windows 10 and later have it too). The protocol is one JSON
+// object per line and is described in context_server.cpp.
+// Connections are handed to a fixed pool of worker threads, so several clients are
+// served at once. Trees are kept warm between requests, and each piece of a context
+// is sent back as a chunk as soon as it is assembled, never the whole text at once.
+class ContextServer
+{
+public:
+    ~ContextServer();
+
+    // Binds socket_path, replacing a stale socket file left by a crashed server, and
+    // starts accepting. Returns false (after logging why) if that is not possible,
+    // e.g. because another instance is already listening there.
+    bool Start(const std::string& socket_path, size_t worker_count = 4);
+    void Stop();
+
+    bool IsRunning() const { return accept_thread.joinable(); }
+    const std::string& SocketPath() const { return socket_path; }
+
+    // Hands the server an up-to-date tree, usually the one the UI just published, so
+    // requests for that root do not have to scan it again.
+    void ShareTree(std::shared_ptr<const FileTree> tree);
+
+private:
+    struct CachedTree
+    {
+        std::shared_ptr<const FileTree> tree;
+        std::chrono::steady_clock::time_point checked;
+        std::shared_future<std::shared_ptr<const FileTree>> scanning;   // Valid while a request scans this root
+    };
+
+    void AcceptLoop();
+    void WorkerLoop();
+    void Serve(intptr_t client);
+    bool HandleRequest(intptr_t client, const std::string& line);
+    std::shared_ptr<const FileTree> TreeFor(const std::string& root_path);
+
+    std::string socket_path;
+    intptr_t listen_socket = -1;
+    std::atomic<bool> stopping{false};
+    std::thread accept_thread;
+    std::vector<std::thread> workers;
+
+    std::mutex queue_mutex;
+    std::condition_variable queue_ready;
+    std::deque<intptr_t> pending_clients;
+    std::vector<intptr_t> active_clients;   // Shut down by Stop() to unblock their workers
+
+    std::mutex trees_mutex;
+    std::map<std::string, CachedTree, std::less<>> trees;
+};
@@ -0,0 +1,141 @@
+#include "context_snapshot.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#include <zstd.h>
+
+#include "context_export.h"
+#include "parallel.h"
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+namespace fs = std::filesystem;
+
+
+// Uncompressed layout (native endianness):
+//   SnapshotHeader | per file: SnapshotFileHeader, path bytes, content bytes
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t file_count;
+};
+
+struct SnapshotFileHeader
+{
+    uint64_t path_size;
+    uint64_t content_size;
+    uint64_t hash;
+};
+
+static const char kSnapshotMagic[8] = {'A', 'C', 'B', 'S', 'N', 'A', 'P', '\0'};
+static constexpr uint32_t kSnapshotVersion = 1;
+
+
+bool SaveContextSnapshot(const ContextSnapshot& snapshot, const std::string& path)
+{
+    ZoneScoped;
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+    header.version = kSnapshotVersion;
+    header.file_count = snapshot.files.size();
+
+    size_t raw_size = sizeof(header);
+    for (const auto& [file_path, file] : snapshot.files) {
+        raw_size += sizeof(SnapshotFileHeader) + file_path.size() + file.content.size();
+    }
+    std::string raw;
+    raw.reserve(raw_size);
+    raw.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& [file_path, file] : snapshot.files)
+    {
+        const SnapshotFileHeader file_header = {file_path.size(), file.content.size(), file.hash};
+        raw.append(reinterpret_cast<const char*>(&file_header), sizeof(file_header));
+        raw += file_path;
+        raw += file.content;
+    }
+
+    std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> context(ZSTD_createCCtx(), ZSTD_freeCCtx);
+    if (!context) {
+        std::cerr << "Could not create a zstd compression context" << std::endl;
+        return false;
+    }
+    ZSTD_CCtx_setParameter(context.get(), ZSTD_c_checksumFlag, 1);
+    ZSTD_CCtx_setParameter(context.get(), ZSTD_c_nbWorkers, static_cast<int>(WorkerCount()));
+    std::string compressed(ZSTD_compressBound(raw.size()), '\0');
+    const size_t compressed_size = ZSTD_compress2(context.get(), compressed.data(), compressed.size(), raw.data(), raw.size());
+    if (ZSTD_isError(compressed_size)) {
+        std::cerr << "Could not compress snapshot " << path << ": " << ZSTD_getErrorName(compressed_size) << std::endl;
+        return false;
+    }
+
+    const std::string temp_path = path + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        out.write(compressed.data(), compressed_size);
+        if (!out) {
+            std::cerr << "Could not write snapshot " << temp_path << std::endl;
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(temp_path, path, ec);
+    if (ec) {
+        std::cerr << "Could not write snapshot " << path << ": " << ec.message() << std::endl;
+        fs::remove(temp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+bool LoadContextSnapshot(const std::string& path, ContextSnapshot& snapshot)
+{
+    ZoneScoped;
+    snapshot.files.clear();
+    std::string raw;
+    if (!LoadCompressedContext(path, raw)) {
+        return false;
+    }
+
+    SnapshotHeader header;
+    if (raw.size() < sizeof(header)) {
+        std::cerr << path << " is not a context snapshot" << std::endl;
+        return false;
+    }
+    std::memcpy(&header, raw.data(), sizeof(header));
+    if (std::memcmp(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 || header.version != kSnapshotVersion) {
+        std::cerr << path << " is not a context snapshot, or one from another version" << std::endl;
+        return false;
+    }
+
+    size_t offset = sizeof(header);
+    for (uint64_t i = 0; i < header.file_count; ++i)
+    {
+        SnapshotFileHeader file_header;
+        if (raw.size() - offset < sizeof(file_header)) {
+            break;
+        }
+        std::memcpy(&file_header, raw.data() + offset, sizeof(file_header));
+        offset += sizeof(file_header);
+        if (file_header.path_size > raw.size() - offset || file_header.content_size > raw.size() - offset - file_header.path_size) {
+            break;
+        }
+        ContextSnapshot::File& file = snapshot.files[raw.substr(offset, file_header.path_size)];
+        offset += file_header.path_size;
+        file.hash = file_header.hash;
+        file.content.assign(raw, offset, file_header.content_size);
+        offset += file_header.content_size;
+    }
+    if (snapshot.files.size() != header.file_count || offset != raw.size()) {
+        std::cerr << "Snapshot " << path << " is damaged" << std::endl;
+        snapshot.files.clear();
+        return false;
+    }
+    return true;
+}
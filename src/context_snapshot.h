@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+// What one generated context contained, file by file: enough to tell which files
+// changed since, and to diff those that did. GenerateContext fills it in; a delta
+// context (see DeltaMode) is then taken against it.
+struct ContextSnapshot
+{
+    struct File
+    {
+        uint64_t hash = 0;      // XXH3 of content
+        std::string content;    // As it went into the context, after the transform
+    };
+    std::map<std::string, File, std::less<>> files;   // By path, like the selection
+};
+
+// Snapshots are kept as a zstd-compressed file, compressed on all cores. Saving
+// writes a temporary file and renames it, so `path` is replaced or left untouched.
+// Both return false after logging why.
+bool SaveContextSnapshot(const ContextSnapshot& snapshot, const std::string& path);
+bool LoadContextSnapshot(const std::string& path, ContextSnapshot& snapshot);
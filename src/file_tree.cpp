@@ -0,0 +1,602 @@
+#include "file_tree.h"
+#include "mapped_file.h"
+#include "metrics.h"
+#include "parallel.h"
+#include "scan_index.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <type_traits>
+#include <unordered_set>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+#endif
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+
+std::string_view FileTree::Name(uint32_t index) const
+{
+    const FileNode& node = nodes[index];
+    return std::string_view(names).substr(node.name_offset, node.name_length);
+}
+
+fs::path FileTree::Path(uint32_t index) const
+{
+    // Collect the chain of ancestors first, then append from the root down so the
+    // result is identical to what fs::directory_iterator would have produced.
+    std::vector<uint32_t> chain;
+    while (index != 0)
+    {
+        chain.push_back(index);
+        index = nodes[index].parent;
+    }
+
+    fs::path result = root_path;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+    {
+        result /= std::string(Name(*it));
+    }
+    return result;
+}
+
+
+uint32_t FileTree::FindChild(uint32_t dir, std::string_view name, bool is_directory) const
+{
+    const FileNode& node = nodes[dir];
+    auto begin = nodes.begin() + node.first_child;
+    auto end = begin + node.child_count;
+    // Same ordering ScanFileTree sorts by: directories first, then by name.
+    auto it = std::lower_bound(begin, end, name, [&](const FileNode& child, std::string_view key) {
+        if (child.is_directory != is_directory) {
+            return child.is_directory;
+        }
+        return std::string_view(names).substr(child.name_offset, child.name_length) < key;
+    });
+    if (it == end || it->is_directory != is_directory || Name(static_cast<uint32_t>(it - nodes.begin())) != name) {
+        return kInvalidNode;
+    }
+    return static_cast<uint32_t>(it - nodes.begin());
+}
+
+uint32_t FileTree::FindPath(std::string_view relative) const
+{
+    uint32_t node = 0;
+    while (!relative.empty())
+    {
+        size_t end = relative.find_first_of("/\\");
+        std::string_view name = relative.substr(0, end);
+        relative = end == std::string_view::npos ? std::string_view() : relative.substr(end + 1);
+        if (name.empty() || name == ".") {
+            continue;
+        }
+        uint32_t child = FindChild(node, name, true);
+        if (child == kInvalidNode && relative.empty()) {
+            child = FindChild(node, name, false);
+        }
+        if (child == kInvalidNode) {
+            return kInvalidNode;
+        }
+        node = child;
+    }
+    return node;
+}
+
+
+bool NeedsPathSeparator(std::string_view path)
+{
+    if (path.empty()) {
+        return false;
+    }
+    const char last = path.back();
+#ifdef _WIN32
+    // "C:" is a root name without a root directory: "C:" / "x" is "C:x".
+    if (last == '\\' || last == '/' || (path.size() == 2 && last == ':')) {
+        return false;
+    }
+#else
+    if (last == '/') {
+        return false;
+    }
+#endif
+    return true;
+}
+
+void AppendPathComponent(std::string& path, std::string_view name)
+{
+    if (NeedsPathSeparator(path)) {
+        path += static_cast<char>(fs::path::preferred_separator);
+    }
+    path += name;
+}
+
+
+static int64_t ToTicks(fs::file_time_type time)
+{
+    return static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+namespace {
+
+struct ScannedEntry
+{
+    std::string name;
+    bool is_directory;
+    bool is_symlink;
+    uint64_t size;
+    int64_t mtime;
+};
+
+// What the scan loop needs to know about a directory before listing it.
+struct DirectoryStat
+{
+    bool has_mtime = false;
+    int64_t mtime = 0;
+    bool has_identity = false;
+    FileIdentity identity;   // Of the directory itself, links followed; detects cycles
+};
+
+// --- Portable enumeration ---
+// fs::directory_iterator, plus a stat for every file's size and another for its mtime.
+struct PortableLister
+{
+    DirectoryStat Stat(const fs::path& path)
+    {
+        DirectoryStat stat;
+        std::error_code ec;
+        stat.mtime = ToTicks(fs::last_write_time(path, ec));
+        AddMetric(Metric::FilesystemCalls);
+        stat.has_mtime = !ec;
+        stat.has_identity = ReadFileIdentity(path.string(), stat.identity);
+        return stat;
+    }
+
+    // Symlinks are left out unless keep_links is set. False if the listing is incomplete.
+    bool List(const fs::path& path, bool keep_links, std::vector<ScannedEntry>& entries)
+    {
+        std::error_code ec;
+        try {
+            uint64_t filesystem_calls = 2; // opendir, closedir
+            for (const auto& entry : fs::directory_iterator(path))
+            {
+                const bool is_symlink = entry.is_symlink(ec);
+                if (is_symlink && !keep_links) {
+                    continue;
+                }
+                ScannedEntry scanned = {entry.path().filename().string(), entry.is_directory(ec), is_symlink, 0, 0};
+                if (!scanned.is_directory)
+                {
+                    scanned.size = entry.file_size(ec);
+                    if (ec) scanned.size = 0;
+                    scanned.mtime = ToTicks(entry.last_write_time(ec));
+                    filesystem_calls += 2; // One stat each
+                }
+                entries.push_back(std::move(scanned));
+            }
+            AddMetric(Metric::FilesystemCalls, filesystem_calls);
+        } catch (const std::exception& e) {
+            // Keep whatever we managed to read; the directory just shows fewer children.
+            std::cerr << "Filesystem error: " << e.what() << std::endl;
+            return false;
+        }
+        return true;
+    }
+};
+
+#ifdef __linux__
+// --- Linux enumeration ---
+// getdents64 returns each entry's type along with its name, so subdirectories need
+// no stat while their parent is listed; each gets exactly one statx when it is
+// itself scanned. Files get one statx for size and mtime together, relative to
+// the open directory so the kernel does not walk the path again. For symlinks the
+// statx follows the link, the same as directory_iterator's is_directory().
+struct LinuxLister
+{
+    int64_t tick_offset = 0;     // Nanoseconds since the Unix epoch -> fs::file_time_type ticks
+    std::vector<char> buffer = std::vector<char>(64 * 1024);
+
+    // The tree keeps mtimes in fs::file_time_type ticks, so trees from either lister
+    // and the scan index stay comparable. C++17 has no clock_cast, so the offset is
+    // measured once by reading the root's mtime both ways.
+    bool Init(const std::string& root_path)
+    {
+        if (!std::is_same<fs::file_time_type::period, std::nano>::value) {
+            return false;
+        }
+        std::error_code ec;
+        const int64_t ticks = ToTicks(fs::last_write_time(root_path, ec));
+        struct statx st;
+        if (ec || statx(AT_FDCWD, root_path.c_str(), AT_STATX_SYNC_AS_STAT, STATX_MTIME, &st) != 0) {
+            return false;
+        }
+        AddMetric(Metric::FilesystemCalls, 2);
+        tick_offset = ticks - Nanoseconds(st.stx_mtime);
+        return true;
+    }
+
+    static int64_t Nanoseconds(const struct statx_timestamp& time)
+    {
+        return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+    }
+
+    DirectoryStat Stat(const fs::path& path)
+    {
+        DirectoryStat stat;
+        struct statx st;
+        AddMetric(Metric::FilesystemCalls);
+        if (statx(AT_FDCWD, path.c_str(), AT_STATX_SYNC_AS_STAT, STATX_MTIME | STATX_INO, &st) == 0)
+        {
+            stat.has_mtime = stat.has_identity = true;
+            stat.mtime = Nanoseconds(st.stx_mtime) + tick_offset;
+            stat.identity.device = makedev(st.stx_dev_major, st.stx_dev_minor);
+            stat.identity.inode = st.stx_ino;
+        }
+        return stat;
+    }
+
+    // Symlinks are left out unless keep_links is set. False if the directory could not
+    // be read to the end; it is then listed as empty, like one that cannot be opened.
+    bool List(const fs::path& path, bool keep_links, std::vector<ScannedEntry>& entries)
+    {
+        const int dir_fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dir_fd < 0) {
+            AddMetric(Metric::FilesystemCalls);
+            std::cerr << "Filesystem error: cannot open " << path.string() << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        const size_t first_entry = entries.size();
+        bool complete = true;
+        uint64_t filesystem_calls = 2; // open, close
+        for (;;)
+        {
+            const long bytes = syscall(SYS_getdents64, dir_fd, buffer.data(), buffer.size());
+            filesystem_calls++;
+            if (bytes < 0)
+            {
+                // A listing cut short would pass for the whole directory, and be reused as such.
+                std::cerr << "Filesystem error: cannot read " << path.string() << ": " << std::strerror(errno) << std::endl;
+                entries.resize(first_entry);
+                complete = false;
+                break;
+            }
+            if (bytes == 0) {
+                break;
+            }
+            for (long offset = 0; offset < bytes;)
+            {
+                const dirent64* entry = reinterpret_cast<const dirent64*>(buffer.data() + offset);
+                offset += entry->d_reclen;
+                const char* name = entry->d_name;
+                if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                    continue;
+                }
+
+                const unsigned int kFileFields = STATX_TYPE | STATX_SIZE | STATX_MTIME;
+                struct statx st;
+                bool have_stat = false;
+                unsigned char type = entry->d_type;
+                if (type == DT_UNKNOWN)
+                {
+                    // Some filesystems do not fill in d_type. Look without following a link first;
+                    // for anything but a link that one call already has everything we need.
+                    filesystem_calls++;
+                    if (statx(dir_fd, name, AT_SYMLINK_NOFOLLOW | AT_STATX_SYNC_AS_STAT, kFileFields, &st) == 0) {
+                        type = S_ISLNK(st.stx_mode) ? DT_LNK : S_ISDIR(st.stx_mode) ? DT_DIR : DT_REG;
+                        have_stat = type != DT_LNK;
+                    }
+                }
+                if (type == DT_LNK && !keep_links) {
+                    continue;
+                }
+
+                ScannedEntry scanned = {name, type == DT_DIR, type == DT_LNK, 0, 0};
+                if (type != DT_DIR)
+                {
+                    if (!have_stat) {
+                        filesystem_calls++;
+                        have_stat = statx(dir_fd, name, AT_STATX_SYNC_AS_STAT, kFileFields, &st) == 0;
+                    }
+                    if (have_stat)
+                    {
+                        scanned.is_directory = S_ISDIR(st.stx_mode);
+                        if (!scanned.is_directory) {
+                            scanned.size = st.stx_size;
+                            scanned.mtime = Nanoseconds(st.stx_mtime) + tick_offset;
+                        }
+                    }
+                }
+                entries.push_back(std::move(scanned));
+            }
+        }
+        close(dir_fd);
+        AddMetric(Metric::FilesystemCalls, filesystem_calls);
+        return complete;
+    }
+};
+#endif
+
+} // namespace
+
+// The scan loop, shared by both listers. Returns how many directory listings were reused.
+template <typename Lister>
+static size_t ScanWith(Lister& lister, FileTree& tree, const std::atomic<bool>* cancel, const FileTree* previous)
+{
+    struct PendingDirectory
+    {
+        uint32_t index;
+        uint32_t previous_index; // Same directory in `previous`, or kInvalidNode
+        fs::path path;
+    };
+    const std::string& root_path = tree.root_path;
+    const LinkPolicy link_policy = tree.link_policy;
+    const bool can_reuse = previous && previous->root_path == root_path && previous->link_policy == link_policy;
+
+    std::deque<PendingDirectory> queue;
+    queue.push_back({0, can_reuse ? 0 : kInvalidNode, fs::path(root_path)});
+    std::vector<ScannedEntry> entries;
+    size_t reused_directories = 0;
+
+    // Identities of the directories scanned so far, by node. A directory whose identity
+    // matches one of its ancestors is a link cycle; under LinkPolicy::Deduplicate one
+    // matching any directory listed before is skipped too.
+    std::vector<FileIdentity> directory_identities;
+    std::unordered_set<FileIdentity, FileIdentityHash> listed_directories;
+    auto is_repeated = [&](uint32_t index, const FileIdentity& identity) {
+        if (link_policy == LinkPolicy::Deduplicate) {
+            return !listed_directories.insert(identity).second;
+        }
+        for (uint32_t ancestor = index; ancestor != 0;)
+        {
+            ancestor = tree.nodes[ancestor].parent;
+            if (directory_identities[ancestor] == identity) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    while (!queue.empty())
+    {
+        if (cancel && cancel->load(std::memory_order_relaxed)) {
+            break;
+        }
+
+        PendingDirectory current = std::move(queue.front());
+        queue.pop_front();
+
+        const DirectoryStat stat = lister.Stat(current.path);
+        tree.nodes[current.index].mtime = stat.has_mtime ? stat.mtime : 0;
+        if (stat.has_identity)
+        {
+            if (directory_identities.size() < tree.nodes.size()) {
+                directory_identities.resize(tree.nodes.size());
+            }
+            directory_identities[current.index] = stat.identity;
+            if (is_repeated(current.index, stat.identity)) {
+                tree.nodes[current.index].is_repeated = true;
+                continue;
+            }
+        }
+
+        // A directory's mtime changes whenever an entry is added, removed or renamed in it,
+        // so an unchanged mtime means the previous listing can be reused as-is.
+        entries.clear();
+        if (current.previous_index != kInvalidNode && stat.has_mtime &&
+            previous->nodes[current.previous_index].mtime == stat.mtime && !previous->nodes[current.previous_index].is_repeated)
+        {
+            const FileNode& old_dir = previous->nodes[current.previous_index];
+            for (uint32_t old = old_dir.first_child; old < old_dir.first_child + old_dir.child_count; ++old)
+            {
+                const FileNode& old_node = previous->nodes[old];
+                entries.push_back({std::string(previous->Name(old)), old_node.is_directory, old_node.is_symlink, old_node.size, old_node.mtime});
+            }
+            ++reused_directories;
+        }
+        else
+        {
+            ZoneScopedN("List Directory");
+            if (!lister.List(current.path, link_policy != LinkPolicy::Skip, entries)) {
+                tree.nodes[current.index].mtime = 0; // Unknown, so neither a rescan nor the scan index reuses it
+            }
+
+            // Directories first, then files, both alphabetically - the order DrawDirectoryTree shows them in.
+            std::sort(entries.begin(), entries.end(), [](const ScannedEntry& a, const ScannedEntry& b) {
+                if (a.is_directory != b.is_directory) {
+                    return a.is_directory;
+                }
+                return a.name < b.name;
+            });
+        }
+
+        const uint32_t first_child = static_cast<uint32_t>(tree.nodes.size());
+        for (const auto& entry : entries)
+        {
+            FileNode node;
+            node.name_offset = static_cast<uint32_t>(tree.names.size());
+            node.name_length = static_cast<uint32_t>(entry.name.size());
+            node.parent = current.index;
+            node.is_directory = entry.is_directory;
+            node.is_symlink = entry.is_symlink;
+            node.size = entry.size;
+            node.mtime = entry.mtime;
+            node.token_count = static_cast<uint32_t>(entry.size / 4); // Same approximation as GenerateContext
+            node.file_count = entry.is_directory ? 0 : 1;
+            tree.names += entry.name;
+
+            if (entry.is_directory)
+            {
+                // Subdirectories are revalidated on their own, even when their parent was unchanged.
+                uint32_t previous_child = current.previous_index == kInvalidNode ? kInvalidNode
+                    : previous->FindChild(current.previous_index, entry.name, true);
+                queue.push_back({static_cast<uint32_t>(tree.nodes.size()), previous_child, current.path / entry.name});
+            }
+            tree.nodes.push_back(node);
+        }
+
+        FileNode& dir = tree.nodes[current.index];
+        dir.first_child = first_child;
+        dir.child_count = static_cast<uint32_t>(entries.size());
+    }
+
+    return reused_directories;
+}
+
+// Breadth-first order stores each depth level as one contiguous range of nodes, and
+// the children of a level are exactly the next range. So once the deeper levels are
+// done, every directory of a level can sum its children independently of the others.
+// Works on partial trees too: directories never listed just have no children.
+static void RollUpDirectoryTotals(FileTree& tree)
+{
+    ZoneScoped;
+    std::vector<std::pair<uint32_t, uint32_t>> levels;
+    for (uint32_t begin = 0, end = 1; begin < end;)
+    {
+        levels.emplace_back(begin, end);
+        uint32_t next_end = end;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            const FileNode& node = tree.nodes[i];
+            if (node.child_count > 0) {
+                next_end = std::max(next_end, node.first_child + node.child_count);
+            }
+        }
+        begin = end;
+        end = next_end;
+    }
+
+    for (auto level = levels.rbegin(); level != levels.rend(); ++level)
+    {
+        const uint32_t level_begin = level->first;
+        ParallelFor(level->second - level_begin, 1024, [&](size_t begin, size_t end, size_t) {
+            for (size_t i = level_begin + begin; i < level_begin + end; ++i)
+            {
+                FileNode& node = tree.nodes[i];
+                if (!node.is_directory) {
+                    continue;
+                }
+                uint64_t size = 0;
+                uint64_t tokens = 0;
+                uint32_t files = 0;
+                for (uint32_t child = node.first_child; child < node.first_child + node.child_count; ++child)
+                {
+                    const FileNode& child_node = tree.nodes[child];
+                    size += child_node.size;
+                    tokens += child_node.token_count;
+                    files += child_node.file_count;
+                }
+                node.size = size;
+                node.token_count = static_cast<uint32_t>(std::min<uint64_t>(tokens, UINT32_MAX));
+                node.file_count = files;
+            }
+        });
+    }
+}
+
+FileTree ScanFileTree(const std::string& root_path, const std::atomic<bool>* cancel, const FileTree* previous, LinkPolicy link_policy)
+{
+    ZoneScoped;
+    ScopedMetricTimer scan_timer(Metric::ScanNanoseconds);
+    FileTree tree;
+    tree.root_path = root_path;
+    tree.link_policy = link_policy;
+
+    FileNode root;
+    root.is_directory = true;
+    tree.nodes.push_back(root);
+
+    [[maybe_unused]] size_t reused_directories = 0; // Only reported to Tracy
+#ifdef __linux__
+    LinuxLister linux_lister;
+    if (linux_lister.Init(root_path)) {
+        reused_directories = ScanWith(linux_lister, tree, cancel, previous);
+    } else
+#endif
+    {
+        PortableLister portable_lister;
+        reused_directories = ScanWith(portable_lister, tree, cancel, previous);
+    }
+    RollUpDirectoryTotals(tree);
+
+    ZoneValue(reused_directories);
+    TracyPlot("Scanned nodes", static_cast<int64_t>(tree.nodes.size()));
+    return tree;
+}
+
+
+BackgroundScan::~BackgroundScan()
+{
+    Cancel();
+}
+
+void BackgroundScan::Shared::Publish(std::shared_ptr<const FileTree> new_tree)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    published = std::move(new_tree);
+    has_new_tree = true;
+}
+
+void BackgroundScan::Cancel()
+{
+    if (pending.valid())
+    {
+        shared->cancel.store(true);
+        pending.wait(); // The scanner checks the flag between directories, so this is short.
+        pending = {};
+    }
+}
+
+void BackgroundScan::Start(const std::string& root_path)
+{
+    Cancel();
+
+    pending_root = root_path;
+    shared = std::make_shared<Shared>();
+    pending = std::async(std::launch::async, [root_path, shared = shared, on_update = on_update, link_policy = link_policy]() {
+        ZoneScopedN("Background Scan");
+        auto notify = [&]() {
+            if (on_update) on_update();
+        };
+        std::shared_ptr<const FileTree> indexed = LoadScanIndex(root_path);
+        if (indexed && indexed->link_policy == link_policy) {
+            shared->Publish(indexed); // Show the cached tree right away, then revalidate it.
+            notify();
+        }
+
+        auto tree = std::make_shared<const FileTree>(ScanFileTree(root_path, &shared->cancel, indexed.get(), link_policy));
+        if (shared->cancel.load()) {
+            return; // Partial trees are neither shown nor cached.
+        }
+        shared->Publish(tree);
+        notify();
+        SaveScanIndex(*tree);
+        notify(); // IsRunning() turns false once Poll() sees the finished future
+    });
+}
+
+bool BackgroundScan::Poll()
+{
+    if (!shared) {
+        return false;
+    }
+    if (pending.valid() && pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        pending.get();
+    }
+
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    if (!shared->has_new_tree) {
+        return false;
+    }
+    shared->has_new_tree = false;
+    tree = shared->published;
+    return true;
+}
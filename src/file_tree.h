@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+
+// One entry of a scanned directory tree. Names live in FileTree::names so a node stays small.
+// The layout is written verbatim into the scan index (see scan_index.h); bump
+// kScanIndexVersion when changing it.
+struct FileNode
+{
+    uint64_t size = 0;          // File size in bytes; for a directory, the total of every file below it
+    int64_t mtime = 0;          // Last write time in fs::file_time_type ticks
+    uint32_t name_offset = 0;
+    uint32_t name_length = 0;
+    uint32_t parent = 0;
+    uint32_t first_child = 0;   // Children of a directory are stored contiguously...
+    uint32_t child_count = 0;   // ...directories first, then files, each sorted by name.
+    uint32_t token_count = 0;   // Estimated tokens of a file (size / 4); for a directory the sum below it, capped at UINT32_MAX
+    uint32_t file_count = 0;    // 1 for a file; for a directory, the number of files below it
+    bool is_directory = false;
+    bool is_symlink = false;    // Reached through a symbolic link; size, mtime and type are the target's
+    bool is_repeated = false;   // A directory already in the tree elsewhere (see LinkPolicy); listed without children
+};
+
+static constexpr uint32_t kInvalidNode = UINT32_MAX;
+
+// What the scanner does with symbolic links. Under every policy a directory is
+// never entered again below itself, so a link cycle cannot hang a scan: the
+// looping entry stays in the tree, marked is_repeated, with no children.
+enum class LinkPolicy : uint8_t
+{
+    Follow,         // Links are scanned like the entries they point to
+    Skip,           // Links are left out of the tree
+    Deduplicate     // Links are followed, but each directory is listed only once, at its shallowest path
+};
+
+// A flattened, in-memory snapshot of the directory tree below root_path.
+// nodes[0] is the root itself. Once built it is immutable, so the UI thread can
+// read it while the next scan is running on a worker thread.
+struct FileTree
+{
+    std::string root_path;
+    std::vector<FileNode> nodes;
+    std::string names;
+    LinkPolicy link_policy = LinkPolicy::Follow;
+
+    std::string_view Name(uint32_t index) const;
+    fs::path Path(uint32_t index) const;
+    // Binary search among the children of `dir`. Returns kInvalidNode if there is no such entry.
+    uint32_t FindChild(uint32_t dir, std::string_view name, bool is_directory) const;
+    // Walks a path relative to root_path ('/' or '\\' separated), one component at a
+    // time; only the last may name a file. An empty path is the root. Returns
+    // kInvalidNode if it does not exist.
+    uint32_t FindPath(std::string_view relative) const;
+};
+
+// fs::path's operator/ without building a path: whether appending a name to `path`
+// needs a separator in between. Keys built this way match FileTree::Path exactly.
+bool NeedsPathSeparator(std::string_view path);
+void AppendPathComponent(std::string& path, std::string_view name);
+
+// Walks root_path breadth-first. Unreadable directories are kept as empty nodes.
+// Once the walk is done, directory sizes, token and file counts are rolled up from
+// the leaves, one depth level at a time with the directories of a level in parallel.
+// If cancel is set while scanning, the partially built tree is returned.
+// When `previous` is given (usually loaded from the scan index), directories whose
+// mtime has not changed reuse its listing instead of being enumerated again, as
+// long as it was scanned with the same link policy.
+FileTree ScanFileTree(const std::string& root_path, const std::atomic<bool>* cancel = nullptr, const FileTree* previous = nullptr,
+                      LinkPolicy link_policy = LinkPolicy::Follow);
+
+
+// Runs ScanFileTree on a worker thread so the UI never waits on the disk.
+// If a scan index exists for the root, its tree is published first and then
+// revalidated, so reopening a large root shows the tree almost immediately.
+class BackgroundScan
+{
+public:
+    ~BackgroundScan();
+
+    // Cancels any scan in flight and starts scanning root_path.
+    void Start(const std::string& root_path);
+    // Call once per frame. Returns true when a new tree has been published.
+    bool Poll();
+
+    // Called on the worker thread whenever Poll() has something new to report: a
+    // published tree or the end of the scan. Lets an idle UI sleep until then.
+    void SetUpdateCallback(std::function<void()> callback) { on_update = std::move(callback); }
+    // Used by the next Start().
+    void SetLinkPolicy(LinkPolicy policy) { link_policy = policy; }
+
+    bool IsRunning() const { return pending.valid(); }
+    const std::string& PendingRoot() const { return pending_root; }
+    std::shared_ptr<const FileTree> Tree() const { return tree; }
+
+private:
+    struct Shared
+    {
+        std::mutex mutex;
+        std::shared_ptr<const FileTree> published;
+        bool has_new_tree = false;
+        std::atomic<bool> cancel{false};
+
+        void Publish(std::shared_ptr<const FileTree> new_tree);
+    };
+
+    void Cancel();
+
+    std::shared_ptr<const FileTree> tree;
+    std::shared_ptr<Shared> shared;
+    std::future<void> pending;
+    std::string pending_root;
+    std::function<void()> on_update;
+    LinkPolicy link_policy = LinkPolicy::Follow;
+};
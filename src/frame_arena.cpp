@@ -0,0 +1,83 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "file_tree.h"
+
+
+FrameArena::FrameArena(size_t initial_size)
+{
+    AddBlock(initial_size);
+}
+
+void FrameArena::AddBlock(size_t minimum_size)
+{
+    const size_t size = std::max(minimum_size, blocks.empty() ? size_t(0) : blocks.back().size * 2);
+    blocks.push_back({std::make_unique<char[]>(size), size});
+    offset = 0;
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+    size_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+    if (aligned + size > blocks.back().size)
+    {
+        AddBlock(size + alignment);
+        aligned = 0;
+    }
+    offset = aligned + size;
+    bytes_used += size;
+    return blocks.back().data.get() + aligned;
+}
+
+std::string_view FrameArena::Copy(std::string_view text)
+{
+    char* out = static_cast<char*>(Allocate(text.size() + 1, 1));
+    std::memcpy(out, text.data(), text.size());
+    out[text.size()] = '\0';
+    return std::string_view(out, text.size());
+}
+
+std::string_view FrameArena::JoinPath(std::string_view parent, std::string_view name)
+{
+    const bool separator = NeedsPathSeparator(parent);
+    const size_t length = parent.size() + (separator ? 1 : 0) + name.size();
+    char* out = static_cast<char*>(Allocate(length + 1, 1));
+    std::memcpy(out, parent.data(), parent.size());
+    if (separator) {
+        out[parent.size()] = static_cast<char>(fs::path::preferred_separator);
+    }
+    std::memcpy(out + length - name.size(), name.data(), name.size());
+    out[length] = '\0';
+    return std::string_view(out, length);
+}
+
+void FrameArena::Reset()
+{
+    last_frame_bytes = bytes_used;
+    if (blocks.size() > 1)
+    {
+        // This frame needed more than one block; next time, fit it all in one.
+        size_t total = Capacity();
+        blocks.clear();
+        AddBlock(total);
+    }
+    offset = 0;
+    bytes_used = 0;
+}
+
+size_t FrameArena::Capacity() const
+{
+    size_t total = 0;
+    for (const Block& block : blocks) {
+        total += block.size;
+    }
+    return total;
+}
+
+FrameArena& GetFrameArena()
+{
+    static FrameArena arena;
+    return arena;
+}
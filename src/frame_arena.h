@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Bump allocator for data that only lives until the end of the frame: paths and
+// labels built while drawing the tree. Allocation is a pointer increment and
+// Reset() frees everything at once. After a frame that outgrew the current block,
+// Reset() replaces the blocks with a single one big enough for that frame, so a
+// steady-state frame never reaches the heap.
+class FrameArena
+{
+public:
+    explicit FrameArena(size_t initial_size = 64 * 1024);
+
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // NUL-terminated copy of `text`, for APIs that want a C string.
+    std::string_view Copy(std::string_view text);
+
+    // `parent` joined with `name` the way fs::path's operator/ would, NUL-terminated.
+    std::string_view JoinPath(std::string_view parent, std::string_view name);
+
+    void Reset();
+
+    size_t BytesUsed() const { return bytes_used; }
+    size_t LastFrameBytes() const { return last_frame_bytes; }
+    size_t Capacity() const;
+
+private:
+    struct Block
+    {
+        std::unique_ptr<char[]> data;
+        size_t size = 0;
+    };
+
+    void AddBlock(size_t minimum_size);
+
+    std::vector<Block> blocks;
+    size_t offset = 0;              // Into blocks.back()
+    size_t bytes_used = 0;
+    size_t last_frame_bytes = 0;
+};
+
+// The UI thread's arena, reset right after FrameMark. Not for use from workers.
+FrameArena& GetFrameArena();
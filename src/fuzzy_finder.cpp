@@ -0,0 +1,209 @@
+#include "fuzzy_finder.h"
+
+#include <algorithm>
+
+#include "parallel.h"
+#include "simd_search.h"
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+
+static char ToLower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Letters and digits get a bit each, everything else shares the remaining 28 bits.
+// A path can only match if its bag contains every bit of the query's bag, which
+// rejects most candidates with a single AND before any scanning happens.
+static uint64_t CharBit(char c)
+{
+    unsigned char u = static_cast<unsigned char>(c);
+    if (u >= 'a' && u <= 'z') return uint64_t(1) << (u - 'a');
+    if (u >= '0' && u <= '9') return uint64_t(1) << (26 + u - '0');
+    return uint64_t(1) << (36 + u % 28);
+}
+
+static uint64_t CharBag(std::string_view text)
+{
+    uint64_t bag = 0;
+    for (char c : text) {
+        bag |= CharBit(c);
+    }
+    return bag;
+}
+
+static bool IsBoundary(char c)
+{
+    return c == '/' || c == '_' || c == '-' || c == '.' || c == ' ';
+}
+
+
+std::shared_ptr<const FuzzyIndex> BuildFuzzyIndex(std::shared_ptr<const FileTree> tree)
+{
+    ZoneScoped;
+    auto index = std::make_shared<FuzzyIndex>();
+    index->tree = tree;
+
+    // Nodes are in breadth-first order, so a parent's path is always known before its children.
+    // Directory paths go to a scratch buffer; only files end up in the index.
+    std::string directory_paths;
+    std::vector<uint32_t> directory_offset(tree->nodes.size(), 0);
+    std::vector<uint32_t> directory_length(tree->nodes.size(), 0);
+
+    auto append_path = [&](std::string& out, uint32_t node) {
+        uint32_t parent = tree->nodes[node].parent;
+        out.append(directory_paths, directory_offset[parent], directory_length[parent]);
+        if (directory_length[parent] > 0) {
+            out += '/';
+        }
+        for (char c : tree->Name(node)) {
+            out += ToLower(c);
+        }
+    };
+
+    for (uint32_t node = 1; node < tree->nodes.size(); ++node)
+    {
+        if (tree->nodes[node].is_directory)
+        {
+            directory_offset[node] = static_cast<uint32_t>(directory_paths.size());
+            append_path(directory_paths, node);
+            directory_length[node] = static_cast<uint32_t>(directory_paths.size()) - directory_offset[node];
+        }
+        else
+        {
+            const uint32_t start = static_cast<uint32_t>(index->paths.size());
+            append_path(index->paths, node);
+            index->offsets.push_back(start);
+            index->filename_offsets.push_back(static_cast<uint32_t>(index->paths.size()) - tree->nodes[node].name_length - start);
+            index->nodes.push_back(node);
+        }
+    }
+    index->offsets.push_back(static_cast<uint32_t>(index->paths.size()));
+
+    index->char_bags.resize(index->nodes.size());
+    ParallelFor(index->nodes.size(), 4096, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            index->char_bags[i] = CharBag(std::string_view(index->paths).substr(index->offsets[i], index->offsets[i + 1] - index->offsets[i]));
+        }
+    });
+    return index;
+}
+
+
+// Scores `text` against `query` (both lower-case), or returns -1 if it does not match.
+// A greedy forward pass finds the earliest complete match, a backward pass then
+// pulls its start as far right as possible so the scored window is as tight as possible.
+static int ScorePath(const char* text, size_t length, size_t filename_start, std::string_view query)
+{
+    size_t pos = 0;
+    size_t last = 0;
+    for (char qc : query)
+    {
+        size_t found = FindByte(text, pos, length, qc);
+        if (found == kNotFound) {
+            return -1;
+        }
+        last = found;
+        pos = found + 1;
+    }
+
+    size_t start = last + 1;
+    for (size_t qi = query.size(); qi > 0; )
+    {
+        --start;
+        if (text[start] == query[qi - 1]) {
+            --qi;
+        }
+    }
+
+    int score = 0;
+    size_t previous = kNotFound;
+    pos = start;
+    for (char qc : query)
+    {
+        size_t found = FindByte(text, pos, last + 1, qc);
+        score += 16;
+        if (found == 0 || IsBoundary(text[found - 1])) {
+            score += 10;
+        }
+        if (previous != kNotFound)
+        {
+            if (found == previous + 1) {
+                score += 12;
+            } else {
+                score -= static_cast<int>(std::min<size_t>(found - previous - 1, 8));
+            }
+        }
+        if (found >= filename_start) {
+            score += 6;
+        }
+        previous = found;
+        pos = found + 1;
+    }
+
+    // Among otherwise equal matches, prefer shorter (usually shallower) paths.
+    return score - static_cast<int>(std::min<size_t>(length / 8, 16));
+}
+
+static bool BetterMatch(const FuzzyMatch& a, const FuzzyMatch& b)
+{
+    if (a.score != b.score) {
+        return a.score > b.score;
+    }
+    return a.node < b.node;
+}
+
+std::vector<FuzzyMatch> FuzzyFind(const FuzzyIndex& index, std::string_view query, size_t max_results)
+{
+    ZoneScoped;
+    std::string needle;
+    for (char c : query)
+    {
+        if (c == ' ' || c == '\t') continue;
+        needle += (c == '\\') ? '/' : ToLower(c);
+    }
+    if (needle.empty() || max_results == 0) {
+        return {};
+    }
+    const uint64_t needle_bag = CharBag(needle);
+
+    // Every worker keeps its own top-K as a min-heap (worst match on top), merged at the end.
+    std::vector<std::vector<FuzzyMatch>> best(WorkerCount());
+    auto heap_order = [](const FuzzyMatch& a, const FuzzyMatch& b) { return BetterMatch(a, b); };
+
+    ParallelFor(index.Size(), 16384, [&](size_t begin, size_t end, size_t worker) {
+        std::vector<FuzzyMatch>& heap = best[worker];
+        for (size_t i = begin; i < end; ++i)
+        {
+            if ((index.char_bags[i] & needle_bag) != needle_bag) {
+                continue;
+            }
+            const uint32_t offset = index.offsets[i];
+            int score = ScorePath(index.paths.data() + offset, index.offsets[i + 1] - offset, index.filename_offsets[i], needle);
+            if (score < 0) {
+                continue;
+            }
+
+            FuzzyMatch match = {index.nodes[i], score};
+            if (heap.size() < max_results) {
+                heap.push_back(match);
+                std::push_heap(heap.begin(), heap.end(), heap_order);
+            } else if (BetterMatch(match, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), heap_order);
+                heap.back() = match;
+                std::push_heap(heap.begin(), heap.end(), heap_order);
+            }
+        }
+    });
+
+    std::vector<FuzzyMatch> results;
+    for (const auto& heap : best) {
+        results.insert(results.end(), heap.begin(), heap.end());
+    }
+    const size_t keep = std::min(results.size(), max_results);
+    std::partial_sort(results.begin(), results.begin() + keep, results.end(), BetterMatch);
+    results.resize(keep);
+    return results;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "file_tree.h"
+
+// Flat, lower-cased list of every file path in a FileTree, laid out for fast
+// fuzzy matching. Built once per scanned tree (on a worker thread), then queried
+// on every keystroke.
+struct FuzzyIndex
+{
+    std::shared_ptr<const FileTree> tree;
+    std::string paths;                       // Root-relative paths, lower-cased and '/'-separated, back to back
+    std::vector<uint32_t> offsets;           // paths of entry i are [offsets[i], offsets[i + 1])
+    std::vector<uint32_t> filename_offsets;  // Where the file name starts within entry i
+    std::vector<uint32_t> nodes;             // FileTree node of entry i
+    std::vector<uint64_t> char_bags;         // Bit set of the characters each path contains
+
+    size_t Size() const { return nodes.size(); }
+};
+
+struct FuzzyMatch
+{
+    uint32_t node;
+    int score;
+};
+
+std::shared_ptr<const FuzzyIndex> BuildFuzzyIndex(std::shared_ptr<const FileTree> tree);
+
+// Returns up to max_results files whose path contains the query characters in order,
+// best first. Matches at the start of path components, consecutive runs and hits in
+// the file name score higher. Whitespace in the query is ignored.
+std::vector<FuzzyMatch> FuzzyFind(const FuzzyIndex& index, std::string_view query, size_t max_results);
@@ -0,0 +1,394 @@
+#include "git_changes.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "git_repository.h"
+#include "mapped_file.h"
+#include "parallel.h"
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+
+// First entry in [begin, end) whose path is not less than `path`. Index entries are
+// sorted byte-wise by path, which is also the order git trees list their entries in.
+static size_t LowerBound(const GitIndex& index, size_t begin, size_t end, std::string_view path)
+{
+    while (begin < end)
+    {
+        const size_t middle = begin + (end - begin) / 2;
+        if (index.Path(index.entries[middle]) < path) {
+            begin = middle + 1;
+        } else {
+            end = middle;
+        }
+    }
+    return begin;
+}
+
+// The entries below `directory` ("a/b/", or empty for all of them).
+static std::pair<size_t, size_t> DirectoryRange(const GitIndex& index, size_t begin, size_t end, std::string directory)
+{
+    if (directory.empty()) {
+        return {begin, end};
+    }
+    const size_t first = LowerBound(index, begin, end, directory);
+    directory.back() = '/' + 1;
+    return {first, LowerBound(index, first, end, directory)};
+}
+
+
+// --- Work tree ---
+struct WorktreeStat
+{
+    bool is_symlink = false;
+    bool executable = false;
+    uint64_t size = 0;
+    int64_t mtime_seconds = 0;
+    uint32_t mtime_nanoseconds = 0;
+    uint32_t inode = 0;
+};
+
+static bool ReadWorktreeStat(const std::string& path, WorktreeStat& stat_data)
+{
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_stat64(path.c_str(), &st) != 0 || !(st.st_mode & _S_IFREG)) {
+        return false;
+    }
+    stat_data.size = st.st_size;
+    stat_data.mtime_seconds = st.st_mtime;
+    return true;
+#else
+    struct stat st;
+    if (lstat(path.c_str(), &st) != 0 || !(S_ISREG(st.st_mode) || S_ISLNK(st.st_mode))) {
+        return false;
+    }
+    stat_data.is_symlink = S_ISLNK(st.st_mode);
+    stat_data.executable = (st.st_mode & S_IXUSR) != 0;
+    stat_data.size = static_cast<uint64_t>(st.st_size);
+    stat_data.mtime_seconds = st.st_mtime;
+#if defined(__APPLE__)
+    stat_data.mtime_nanoseconds = static_cast<uint32_t>(st.st_mtimespec.tv_nsec);
+#else
+    stat_data.mtime_nanoseconds = static_cast<uint32_t>(st.st_mtim.tv_nsec);
+#endif
+    stat_data.inode = static_cast<uint32_t>(st.st_ino);
+    return true;
+#endif
+}
+
+// Whether the work tree file still holds what its index entry staged. Matching stat
+// data settles it, unless the file was written in the same instant as the index
+// (racy: it may have changed again after being hashed). A differing size settles it
+// the other way, except that git zeroes the size of entries it found racy.
+static bool WorktreeMatches(const GitIndex& index, const GitIndexEntry& entry, const std::string& path, std::atomic<size_t>& hashed)
+{
+    WorktreeStat st;
+    if (!ReadWorktreeStat(path, st)) {
+        return false; // Deleted, or replaced by a directory
+    }
+#ifndef _WIN32
+    const bool entry_is_symlink = (entry.mode & 0170000) == kGitModeSymlink;
+    if (st.is_symlink != entry_is_symlink || (!st.is_symlink && st.executable != ((entry.mode & 0100) != 0))) {
+        return false;
+    }
+#endif
+    if (entry.size != 0 && static_cast<uint32_t>(st.size) != entry.size) {
+        return false;
+    }
+    const bool racy = entry.mtime_seconds > index.mtime_seconds ||
+                      (entry.mtime_seconds == index.mtime_seconds && entry.mtime_nanoseconds >= index.mtime_nanoseconds);
+#ifdef _WIN32
+    const bool stat_matches = static_cast<uint32_t>(st.mtime_seconds) == entry.mtime_seconds;
+#else
+    const bool stat_matches = static_cast<uint32_t>(st.mtime_seconds) == entry.mtime_seconds &&
+                              st.mtime_nanoseconds == entry.mtime_nanoseconds && st.inode == entry.inode;
+#endif
+    if (stat_matches && !racy && entry.size != 0) {
+        return true;
+    }
+
+    hashed.fetch_add(1, std::memory_order_relaxed);
+#ifndef _WIN32
+    if (st.is_symlink)
+    {
+        // A symlink's blob is its target.
+        std::string target(st.size + 1, '\0');
+        const ssize_t length = readlink(path.c_str(), target.data(), target.size());
+        if (length < 0) {
+            return false;
+        }
+        target.resize(static_cast<size_t>(length));
+        return HashGitBlob(target) == entry.id;
+    }
+#endif
+    MappedFile file(path);
+    return file.IsRegularFile() && HashGitBlob(file.View()) == entry.id;
+}
+
+// Marks the entries in [begin, end) whose work tree file differs. Unmerged and
+// intent-to-add entries always differ; sparse checkout entries never do.
+static void FindWorktreeChanges(const GitRepository& repo, const GitIndex& index, size_t begin, size_t end, std::vector<uint8_t>& changed,
+                                std::atomic<size_t>& hashed)
+{
+    ZoneScoped;
+    ParallelFor(end - begin, 512, [&](size_t first, size_t last, size_t) {
+        std::string path = repo.WorkTree();
+        AppendPathComponent(path, "");
+        const size_t base_length = path.size();
+        for (size_t i = begin + first; i < begin + last; ++i)
+        {
+            const GitIndexEntry& entry = index.entries[i];
+            if (entry.skip_worktree || (entry.mode & 0170000) == kGitModeSubmodule) {
+                continue;
+            }
+            if (entry.stage != 0 || entry.intent_to_add) {
+                changed[i] = 1;
+                continue;
+            }
+            path.resize(base_length);
+            path.append(index.Path(entry));
+            if (!WorktreeMatches(index, entry, path, hashed)) {
+                changed[i] = 1;
+            }
+        }
+    });
+}
+
+
+// --- Commit against index ---
+// Walks a commit's tree alongside the index, marking entries that differ from it
+// or are missing from it (added), and collecting paths only the tree has (removed).
+struct TreeIndexDiff
+{
+    const GitRepository& repo;
+    const GitIndex& index;
+    std::vector<uint8_t>& changed;
+    std::vector<std::string>& removed;
+    std::vector<uint8_t> covered;
+    std::string error;
+
+    bool Compare(const GitObjectId& tree_id, std::string& prefix, size_t begin, size_t end, const GitCacheTree* cache);
+    bool ListRemoved(const GitObjectId& tree_id, std::string& prefix);
+    bool ReadTree(const GitObjectId& tree_id, GitObject& object, std::vector<GitTreeEntry>& entries);
+};
+
+bool TreeIndexDiff::ReadTree(const GitObjectId& tree_id, GitObject& object, std::vector<GitTreeEntry>& entries)
+{
+    if (!repo.ReadObject(tree_id, object) || object.type != GitObjectType::Tree || !ParseGitTree(object.data, entries)) {
+        error = "could not read tree " + tree_id.ToHex();
+        return false;
+    }
+    return true;
+}
+
+bool TreeIndexDiff::Compare(const GitObjectId& tree_id, std::string& prefix, size_t begin, size_t end, const GitCacheTree* cache)
+{
+    if (cache && cache->valid && cache->id == tree_id)
+    {
+        std::fill(covered.begin() + begin, covered.begin() + end, uint8_t(1));
+        return true;
+    }
+    GitObject object;
+    std::vector<GitTreeEntry> entries;
+    if (!ReadTree(tree_id, object, entries)) {
+        return false;
+    }
+    for (const GitTreeEntry& tree_entry : entries)
+    {
+        const size_t prefix_length = prefix.size();
+        prefix.append(tree_entry.name);
+        if (tree_entry.mode == kGitModeDirectory)
+        {
+            prefix += '/';
+            auto [first, last] = DirectoryRange(index, begin, end, prefix);
+            if (first < last && index.Path(index.entries[first]) == prefix)
+            {
+                // A sparse index keeps a whole directory outside the checkout as one entry.
+                covered[first] = 1;
+                changed[first] |= index.entries[first].id != tree_entry.id;
+                ++first;
+            }
+            const bool ok = first == last ? ListRemoved(tree_entry.id, prefix)
+                                          : Compare(tree_entry.id, prefix, first, last, cache ? cache->Child(tree_entry.name) : nullptr);
+            if (!ok) {
+                return false;
+            }
+        }
+        else
+        {
+            size_t i = LowerBound(index, begin, end, prefix);
+            if (i == end || index.Path(index.entries[i]) != prefix) {
+                removed.push_back(prefix);
+            }
+            for (; i < end && index.Path(index.entries[i]) == prefix; ++i)
+            {
+                const GitIndexEntry& entry = index.entries[i];
+                covered[i] = 1;
+                changed[i] |= entry.stage != 0 || entry.id != tree_entry.id || entry.mode != tree_entry.mode;
+            }
+        }
+        prefix.resize(prefix_length);
+    }
+    return true;
+}
+
+bool TreeIndexDiff::ListRemoved(const GitObjectId& tree_id, std::string& prefix)
+{
+    GitObject object;
+    std::vector<GitTreeEntry> entries;
+    if (!ReadTree(tree_id, object, entries)) {
+        return false;
+    }
+    for (const GitTreeEntry& tree_entry : entries)
+    {
+        const size_t prefix_length = prefix.size();
+        prefix.append(tree_entry.name);
+        if (tree_entry.mode == kGitModeDirectory)
+        {
+            prefix += '/';
+            if (!ListRemoved(tree_entry.id, prefix)) {
+                return false;
+            }
+        }
+        else
+        {
+            removed.push_back(prefix);
+        }
+        prefix.resize(prefix_length);
+    }
+    return true;
+}
+
+// Compares the tree of `revision` below `directory` with the index entries in
+// [begin, end), which are those below the same directory.
+static bool CompareWithCommit(const GitRepository& repo, const GitIndex& index, std::string_view revision, const std::string& directory,
+                              size_t begin, size_t end, std::vector<uint8_t>& changed, std::vector<std::string>& removed, std::string& error)
+{
+    ZoneScoped;
+    GitObjectId commit, tree_id;
+    if (!repo.ResolveCommit(revision, commit, error)) {
+        return false;
+    }
+    if (!repo.CommitTree(commit, tree_id)) {
+        error = "could not read commit " + commit.ToHex();
+        return false;
+    }
+
+    // Down to the tree's root directory, if it is not the work tree's.
+    const GitCacheTree* cache = &index.cache_tree;
+    bool found = true;
+    for (size_t pos = 0; pos < directory.size() && found;)
+    {
+        const size_t slash = directory.find('/', pos);
+        const std::string_view name = std::string_view(directory).substr(pos, slash - pos);
+        pos = slash + 1;
+        GitObject object;
+        std::vector<GitTreeEntry> entries;
+        found = repo.ReadObject(tree_id, object) && ParseGitTree(object.data, entries);
+        auto it = std::find_if(entries.begin(), entries.end(),
+                               [&](const GitTreeEntry& entry) { return entry.name == name && entry.mode == kGitModeDirectory; });
+        found = found && it != entries.end();
+        if (found) {
+            tree_id = it->id;
+            cache = cache ? cache->Child(name) : nullptr;
+        }
+    }
+
+    TreeIndexDiff diff{repo, index, changed, removed, std::vector<uint8_t>(index.entries.size()), {}};
+    std::string prefix = directory;
+    if (found && !diff.Compare(tree_id, prefix, begin, end, cache)) {
+        error = diff.error;
+        return false;
+    }
+    // Added since the commit. Intent-to-add entries have nothing staged yet.
+    for (size_t i = begin; i < end; ++i) {
+        changed[i] |= !diff.covered[i] && !index.entries[i].intent_to_add;
+    }
+    return true;
+}
+
+
+GitChangesResult FindGitChanges(const FileTree& tree, const GitChangesOptions& options)
+{
+    ZoneScoped;
+    GitChangesResult result;
+    GitRepository repo;
+    if (!repo.Open(tree.root_path)) {
+        result.error = tree.root_path + " is not in a git repository";
+        return result;
+    }
+    GitIndex index;
+    if (!repo.ReadIndex(index, result.error)) {
+        return result;
+    }
+
+    // Index paths are relative to the work tree; the tree may be rooted further down.
+    std::error_code ec;
+    std::string directory = fs::absolute(tree.root_path, ec).lexically_normal().lexically_relative(repo.WorkTree()).generic_string();
+    while (!directory.empty() && directory.back() == '/') {
+        directory.pop_back();
+    }
+    if (directory == ".") {
+        directory.clear();
+    }
+    if (!directory.empty()) {
+        directory += '/';
+    }
+    const auto [begin, end] = DirectoryRange(index, 0, index.entries.size(), directory);
+    result.index_entries = end - begin;
+
+    std::vector<uint8_t> changed(index.entries.size());
+    std::vector<std::string> removed;
+    std::atomic<size_t> hashed{0};
+    if (options.worktree || !options.since.empty()) {
+        FindWorktreeChanges(repo, index, begin, end, changed, hashed);
+    }
+    if (options.staged)
+    {
+        std::string unborn;
+        GitObjectId head;
+        if (repo.ResolveCommit("HEAD", head, unborn)) {
+            if (!CompareWithCommit(repo, index, "HEAD", directory, begin, end, changed, removed, result.error)) {
+                return result;
+            }
+        } else {
+            std::fill(changed.begin() + begin, changed.begin() + end, uint8_t(1)); // No commits yet: all of it is staged
+        }
+    }
+    if (!options.since.empty() && !CompareWithCommit(repo, index, options.since, directory, begin, end, changed, removed, result.error)) {
+        return result;
+    }
+    result.files_hashed = hashed.load();
+
+    std::vector<std::string_view> paths;
+    for (size_t i = begin; i < end; ++i)
+    {
+        if (changed[i]) {
+            paths.push_back(index.Path(index.entries[i]));
+        }
+    }
+    for (const std::string& path : removed) {
+        paths.push_back(path);
+    }
+    std::sort(paths.begin(), paths.end());
+    paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+    result.changed_paths = paths.size();
+
+    for (std::string_view path : paths)
+    {
+        const uint32_t node = tree.FindPath(path.substr(directory.size()));
+        if (node != kInvalidNode && !tree.nodes[node].is_directory) {
+            result.nodes.push_back(node);
+        }
+    }
+    std::sort(result.nodes.begin(), result.nodes.end());
+    return result;
+}
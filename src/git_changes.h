@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "file_tree.h"
+
+// Which tracked files count as changed. Any combination may be asked for; the
+// result is the union. Untracked files are never included.
+struct GitChangesOptions
+{
+    bool worktree = true;   // Edited, deleted or unmerged since last staged, as in git diff
+    bool staged = true;     // Staged but not committed, as in git diff --cached
+    std::string since;      // A revision such as main or HEAD~3: anything committed, staged or edited since
+};
+
+struct GitChangesResult
+{
+    std::vector<uint32_t> nodes;   // Changed files present in the tree, in node order
+    size_t changed_paths = 0;      // Also counts deleted files, which have no node
+    size_t index_entries = 0;      // Below the tree's root
+    size_t files_hashed = 0;       // Work tree files whose stat data did not settle it
+    std::string error;             // No repository, an unknown revision, a damaged object...
+};
+
+// Reads the repository the tree's root is in directly: the index, refs and the
+// object database, without running git. Work tree files are compared with their
+// index entries by lstat on all cores, and only read when the stat data changed
+// or is racy, as git does; directories the index's cache tree says match a commit
+// are skipped without reading their trees. Content filters (autocrlf, clean
+// filters) are not applied, so files they rewrite may show up as changed.
+GitChangesResult FindGitChanges(const FileTree& tree, const GitChangesOptions& options);
@@ -0,0 +1,233 @@
+#include "git_commit_source.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#include "file_tree.h"
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+namespace fs = std::filesystem;
+
+
+// Resolves "." and ".." in a '/'-separated path relative to the work tree, which
+// is the empty path. False if it climbs out of it.
+static bool NormalizeGitPath(std::string& path)
+{
+    std::vector<std::string_view> parts;
+    std::string_view rest = path;
+    while (!rest.empty())
+    {
+        const size_t slash = rest.find('/');
+        const std::string_view part = rest.substr(0, slash);
+        rest = slash == std::string_view::npos ? std::string_view() : rest.substr(slash + 1);
+        if (part.empty() || part == ".") {
+            continue;
+        }
+        if (part == "..") {
+            if (parts.empty()) return false;
+            parts.pop_back();
+            continue;
+        }
+        parts.push_back(part);
+    }
+    std::string normalized;
+    for (std::string_view part : parts)
+    {
+        if (!normalized.empty()) normalized += '/';
+        normalized.append(part);
+    }
+    path = std::move(normalized);
+    return true;
+}
+
+
+bool GitCommitSource::Open(const std::vector<std::string>& root_paths, const std::string& revision_name, std::string& error)
+{
+    ZoneScoped;
+    revision = revision_name;
+    repositories.clear();
+    for (const std::string& root : root_paths)
+    {
+        auto opened = std::make_unique<Repository>();
+        if (!opened->repository.Open(root)) {
+            error = root + " is not in a git repository";
+            return false;
+        }
+        opened->work_tree = opened->repository.WorkTree();
+        AppendPathComponent(opened->work_tree, "");
+        const bool known = std::any_of(repositories.begin(), repositories.end(),
+                                       [&](const auto& repository) { return repository->work_tree == opened->work_tree; });
+        if (known) {
+            continue;
+        }
+        GitObjectId commit;
+        if (!opened->repository.ResolveCommit(revision, commit, error)) {
+            error += " in " + opened->repository.WorkTree();
+            return false;
+        }
+        if (!opened->repository.CommitTree(commit, opened->tree)) {
+            error = "could not read commit " + commit.ToHex();
+            return false;
+        }
+        repositories.push_back(std::move(opened));
+    }
+    return true;
+}
+
+const GitCommitSource::Listing* GitCommitSource::ListingOf(const Repository& repository, const GitObjectId& tree) const
+{
+    auto found = repository.listings.find(tree);
+    if (found != repository.listings.end()) {
+        return found->second.get();
+    }
+    auto listing = std::make_unique<Listing>();
+    if (!repository.repository.ReadObject(tree, listing->object) || listing->object.type != GitObjectType::Tree ||
+        !ParseGitTree(listing->object.data, listing->entries)) {
+        return nullptr;
+    }
+    // Git orders a directory as if its name ended in '/'; plain names are easier to search.
+    std::sort(listing->entries.begin(), listing->entries.end(), [](const GitTreeEntry& a, const GitTreeEntry& b) { return a.name < b.name; });
+    return repository.listings.emplace(tree, std::move(listing)).first->second.get();
+}
+
+// Walks the commit's trees down `path`, to a blob or a tree. A symlink on the way
+// restarts the walk at its target, as the file system would, a few times at most.
+bool GitCommitSource::Resolve(const Repository& repository, std::string path, GitObjectId& id, uint32_t& mode) const
+{
+    for (int links = 0; links < 8; ++links)
+    {
+        id = repository.tree;
+        mode = kGitModeDirectory;
+        bool followed_link = false;
+        for (size_t pos = 0; pos < path.size() && !followed_link;)
+        {
+            const Listing* listing = mode == kGitModeDirectory ? ListingOf(repository, id) : nullptr;
+            if (!listing) {
+                return false;
+            }
+            const size_t slash = path.find('/', pos);
+            const std::string_view name = std::string_view(path).substr(pos, slash - pos);
+            auto entry = std::lower_bound(listing->entries.begin(), listing->entries.end(), name,
+                                          [](const GitTreeEntry& e, std::string_view key) { return e.name < key; });
+            if (entry == listing->entries.end() || entry->name != name) {
+                return false;
+            }
+            if ((entry->mode & 0170000) == kGitModeSymlink)
+            {
+                GitObject target;
+                if (!repository.repository.ReadObject(entry->id, target) || target.data.empty() || target.data[0] == '/') {
+                    return false; // Absolute targets are outside the commit
+                }
+                std::string next = path.substr(0, pos) + target.data;
+                if (slash != std::string::npos) {
+                    next += path.substr(slash);
+                }
+                if (!NormalizeGitPath(next)) {
+                    return false;
+                }
+                path = std::move(next);
+                followed_link = true;
+                continue;
+            }
+            id = entry->id;
+            mode = entry->mode;
+            pos = slash == std::string::npos ? path.size() : slash + 1;
+        }
+        if (!followed_link) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const GitCommitSource::Repository* GitCommitSource::Locate(const std::string& path, std::string& git_path) const
+{
+    std::error_code ec;
+    const std::string absolute = fs::absolute(path, ec).lexically_normal().string();
+    const Repository* repository = nullptr;
+    for (const auto& candidate : repositories)
+    {
+        // The innermost work tree, should one repository be nested in another.
+        const std::string_view work_tree(candidate->work_tree.data(), candidate->work_tree.size() - 1); // Without its separator
+        const bool inside = absolute.compare(0, work_tree.size(), work_tree) == 0 &&
+                            (absolute.size() == work_tree.size() || absolute[work_tree.size()] == candidate->work_tree.back());
+        if (inside && (!repository || candidate->work_tree.size() > repository->work_tree.size())) {
+            repository = candidate.get();
+        }
+    }
+    if (!repository) {
+        return nullptr;
+    }
+    git_path = absolute.size() > repository->work_tree.size() ? absolute.substr(repository->work_tree.size()) : std::string();
+    std::replace(git_path.begin(), git_path.end(), '\\', '/');
+    return NormalizeGitPath(git_path) ? repository : nullptr;
+}
+
+bool GitCommitSource::Read(const std::string& path, std::string& content) const
+{
+    std::string git_path;
+    const Repository* repository = Locate(path, git_path);
+    if (!repository) {
+        return false;
+    }
+    GitObjectId blob;
+    uint32_t mode;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!Resolve(*repository, git_path, blob, mode)) {
+            return false;
+        }
+    }
+    const uint32_t type = mode & 0170000;
+    if (type == kGitModeDirectory || type == kGitModeSubmodule) {
+        return false;
+    }
+    GitObject object;
+    if (!repository->repository.ReadObject(blob, object) || object.type != GitObjectType::Blob) {
+        return false;
+    }
+    content = std::move(object.data);
+    return true;
+}
+
+bool GitCommitSource::ListFiles(const std::string& path, std::vector<std::string>& files) const
+{
+    ZoneScoped;
+    std::string git_path;
+    const Repository* repository = Locate(path, git_path);
+    if (!repository) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    GitObjectId id;
+    uint32_t mode;
+    if (!Resolve(*repository, git_path, id, mode) || (mode & 0170000) == kGitModeSubmodule) {
+        return false;
+    }
+    if (mode != kGitModeDirectory) {
+        files.push_back(path);
+        return true;
+    }
+    std::string key = path;
+    auto walk = [&](auto& self, const GitObjectId& tree) -> bool {
+        const Listing* listing = ListingOf(*repository, tree);
+        if (!listing) {
+            return false;
+        }
+        for (const GitTreeEntry& entry : listing->entries)
+        {
+            const size_t key_length = key.size();
+            AppendPathComponent(key, entry.name);
+            if (entry.mode == kGitModeDirectory) {
+                if (!self(self, entry.id)) return false;
+            } else if ((entry.mode & 0170000) != kGitModeSubmodule) {
+                files.push_back(key);
+            }
+            key.resize(key_length);
+        }
+        return true;
+    };
+    return walk(walk, id);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "git_repository.h"
+
+// The files of one commit, looked up by their paths in the work tree, so a context
+// can be generated from a branch, tag or commit instead of whatever is on disk
+// (ContextOptions::source). Blobs come straight from the object database; packs
+// stay mapped for as long as the source is open.
+class GitCommitSource
+{
+public:
+    // Resolves `revision` in the repository of every root; the roots of a workspace
+    // may be in different ones. False, with `error` set, if a root is not in a
+    // repository or its repository has no such revision.
+    bool Open(const std::vector<std::string>& root_paths, const std::string& revision, std::string& error);
+
+    const std::string& Revision() const { return revision; }
+
+    // The content the commit has for the file at `path` (a selection key: relative
+    // paths are taken from the current directory). Symlinks are followed inside the
+    // commit. False for directories, files the commit does not have, and paths
+    // outside every opened repository. Any number of threads may read at once:
+    // the lookup shares each tree, read once, under a lock; the blob is inflated
+    // outside it.
+    bool Read(const std::string& path, std::string& content) const;
+    // Appends every file the commit has at or below `path` to `files`, named the way
+    // FileTree::Path names them below a root of `path`. Symlinks are listed as files.
+    // False if the commit has nothing there.
+    bool ListFiles(const std::string& path, std::vector<std::string>& files) const;
+
+private:
+    // One tree object, with its entries sorted by name for lookups.
+    struct Listing
+    {
+        GitObject object;
+        std::vector<GitTreeEntry> entries;
+    };
+
+    struct Repository
+    {
+        GitRepository repository;
+        std::string work_tree;   // With a trailing separator
+        GitObjectId tree;        // The commit's root tree
+        mutable std::map<GitObjectId, std::unique_ptr<Listing>> listings;
+    };
+
+    const Repository* Locate(const std::string& path, std::string& git_path) const;
+    const Listing* ListingOf(const Repository& repository, const GitObjectId& tree) const;
+    bool Resolve(const Repository& repository, std::string path, GitObjectId& id, uint32_t& mode) const;
+
+    std::string revision;
+    std::vector<std::unique_ptr<Repository>> repositories;
+    mutable std::mutex mutex;   // Guards every Repository::listings
+};
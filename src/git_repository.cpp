@@ -0,0 +1,1024 @@
+#include "git_repository.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <new>
+
+#include <sys/stat.h>
+#include <zlib.h>
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+namespace fs = std::filesystem;
+
+
+// --- Object ids ---
+bool GitObjectId::operator==(const GitObjectId& other) const
+{
+    return std::memcmp(bytes, other.bytes, sizeof(bytes)) == 0;
+}
+
+bool GitObjectId::operator<(const GitObjectId& other) const
+{
+    return std::memcmp(bytes, other.bytes, sizeof(bytes)) < 0;
+}
+
+std::string GitObjectId::ToHex() const
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(40, '0');
+    for (size_t i = 0; i < sizeof(bytes); ++i)
+    {
+        hex[2 * i] = digits[bytes[i] >> 4];
+        hex[2 * i + 1] = digits[bytes[i] & 15];
+    }
+    return hex;
+}
+
+static int HexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool IsHex(std::string_view text)
+{
+    return std::all_of(text.begin(), text.end(), [](char c) { return HexValue(c) >= 0; });
+}
+
+bool GitObjectId::FromHex(std::string_view hex, GitObjectId& id)
+{
+    if (hex.size() != 40 || !IsHex(hex)) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(id.bytes); ++i) {
+        id.bytes[i] = static_cast<uint8_t>(HexValue(hex[2 * i]) << 4 | HexValue(hex[2 * i + 1]));
+    }
+    return true;
+}
+
+
+// --- SHA-1 ---
+namespace {
+
+class Sha1
+{
+public:
+    void Update(const void* data, size_t size)
+    {
+        if (size == 0) {
+            return; // An empty file hashes nothing, and may come with no data pointer at all
+        }
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        length += size;
+        if (buffered > 0)
+        {
+            const size_t take = std::min(size, sizeof(buffer) - buffered);
+            std::memcpy(buffer + buffered, bytes, take);
+            buffered += take;
+            bytes += take;
+            size -= take;
+            if (buffered < sizeof(buffer)) {
+                return;
+            }
+            Block(buffer);
+            buffered = 0;
+        }
+        for (; size >= 64; bytes += 64, size -= 64) {
+            Block(bytes);
+        }
+        std::memcpy(buffer, bytes, size);
+        buffered = size;
+    }
+
+    GitObjectId Final()
+    {
+        const uint64_t bits = length * 8;
+        static const uint8_t padding[64] = {0x80};
+        Update(padding, buffered < 56 ? 56 - buffered : 120 - buffered);
+        uint8_t length_bytes[8];
+        for (int i = 0; i < 8; ++i) {
+            length_bytes[i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+        }
+        Update(length_bytes, sizeof(length_bytes));
+
+        GitObjectId id;
+        for (int i = 0; i < 5; ++i)
+        {
+            for (int k = 0; k < 4; ++k) {
+                id.bytes[4 * i + k] = static_cast<uint8_t>(h[i] >> (24 - 8 * k));
+            }
+        }
+        return id;
+    }
+
+private:
+    static uint32_t Rotate(uint32_t value, int bits) { return (value << bits) | (value >> (32 - bits)); }
+
+    void Block(const uint8_t* block)
+    {
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = uint32_t(block[4 * i]) << 24 | uint32_t(block[4 * i + 1]) << 16 | uint32_t(block[4 * i + 2]) << 8 | block[4 * i + 3];
+        }
+        for (int i = 16; i < 80; ++i) {
+            w[i] = Rotate(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; ++i)
+        {
+            uint32_t f, k;
+            if (i < 20) { f = (b & c) | (~b & d); k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else { f = b ^ c ^ d; k = 0xCA62C1D6; }
+            const uint32_t temp = Rotate(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = Rotate(b, 30);
+            b = a;
+            a = temp;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    uint8_t buffer[64];
+    size_t buffered = 0;
+    uint64_t length = 0;
+};
+
+} // namespace
+
+GitObjectId HashGitBlob(std::string_view content)
+{
+    Sha1 sha;
+    const std::string header = "blob " + std::to_string(content.size());
+    sha.Update(header.c_str(), header.size() + 1); // With its NUL
+    sha.Update(content.data(), content.size());
+    return sha.Final();
+}
+
+
+// --- Helpers ---
+static uint32_t ReadBigEndian32(const char* p)
+{
+    const uint8_t* b = reinterpret_cast<const uint8_t*>(p);
+    return uint32_t(b[0]) << 24 | uint32_t(b[1]) << 16 | uint32_t(b[2]) << 8 | b[3];
+}
+
+static uint16_t ReadBigEndian16(const char* p)
+{
+    const uint8_t* b = reinterpret_cast<const uint8_t*>(p);
+    return static_cast<uint16_t>(b[0] << 8 | b[1]);
+}
+
+// Deflate's best case: no stream expands by more than this per compressed byte. A
+// size claiming more comes from a damaged object and is never allocated.
+static constexpr uint64_t kMaxInflateRatio = 1032;
+
+static bool PlausibleInflatedSize(uint64_t size, size_t compressed)
+{
+    return size / kMaxInflateRatio <= compressed && size <= std::numeric_limits<size_t>::max() / 2;
+}
+
+// Inflates a zlib stream known to produce exactly `size` bytes. `available` may run
+// past the end of the stream, as it does inside a pack.
+static bool Inflate(const char* data, size_t available, size_t size, std::string& out)
+{
+    if (!PlausibleInflatedSize(size, available)) {
+        return false;
+    }
+    try {
+        out.resize(size);
+    } catch (const std::bad_alloc&) {
+        return false;
+    }
+    z_stream stream = {};
+    if (inflateInit(&stream) != Z_OK) {
+        return false;
+    }
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(std::min<size_t>(available, UINT32_MAX));
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = static_cast<uInt>(size);
+    const int result = inflate(&stream, Z_FINISH);
+    const bool ok = result == Z_STREAM_END && stream.total_out == size;
+    inflateEnd(&stream);
+    return ok;
+}
+
+static GitObjectType ObjectTypeFromName(std::string_view name)
+{
+    if (name == "blob") return GitObjectType::Blob;
+    if (name == "tree") return GitObjectType::Tree;
+    if (name == "commit") return GitObjectType::Commit;
+    if (name == "tag") return GitObjectType::Tag;
+    return GitObjectType::None;
+}
+
+// Pack deltas: the base and result sizes, then copy-from-base and insert instructions.
+static bool ApplyDelta(std::string_view base, std::string_view delta, std::string& out)
+{
+    size_t pos = 0;
+    auto read_size = [&](uint64_t& value) {
+        value = 0;
+        for (int shift = 0; pos < delta.size() && shift < 64; shift += 7)
+        {
+            const uint8_t byte = static_cast<uint8_t>(delta[pos++]);
+            value |= uint64_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    };
+    uint64_t base_size, result_size;
+    if (!read_size(base_size) || !read_size(result_size) || base_size != base.size()) {
+        return false;
+    }
+    out.clear();
+    out.reserve(std::min<uint64_t>(result_size, base.size() + delta.size())); // A hint; never trust a damaged header's size
+    while (pos < delta.size())
+    {
+        const uint8_t op = static_cast<uint8_t>(delta[pos++]);
+        if (op & 0x80)
+        {
+            uint64_t offset = 0, size = 0;
+            for (int i = 0; i < 4; ++i) {
+                if (op & (1 << i)) {
+                    if (pos >= delta.size()) return false;
+                    offset |= uint64_t(static_cast<uint8_t>(delta[pos++])) << (8 * i);
+                }
+            }
+            for (int i = 0; i < 3; ++i) {
+                if (op & (0x10 << i)) {
+                    if (pos >= delta.size()) return false;
+                    size |= uint64_t(static_cast<uint8_t>(delta[pos++])) << (8 * i);
+                }
+            }
+            if (size == 0) {
+                size = 0x10000;
+            }
+            if (offset > base.size() || size > base.size() - offset || size > result_size - out.size()) {
+                return false;
+            }
+            out.append(base.data() + offset, size);
+        }
+        else if (op != 0)
+        {
+            if (op > delta.size() - pos || op > result_size - out.size()) {
+                return false;
+            }
+            out.append(delta.data() + pos, op);
+            pos += op;
+        }
+        else
+        {
+            return false; // Reserved
+        }
+    }
+    return out.size() == result_size;
+}
+
+// First line of a small file such as a loose ref, without its newline.
+static bool ReadFirstLine(const std::string& path, std::string& line)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open() || !std::getline(in, line)) {
+        return false;
+    }
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) {
+        line.pop_back();
+    }
+    return true;
+}
+
+
+// --- Opening ---
+bool GitRepository::Open(const std::string& path)
+{
+    ZoneScoped;
+    *this = GitRepository();
+    std::error_code ec;
+    fs::path directory = fs::absolute(path, ec).lexically_normal();
+    if (!directory.has_filename()) {
+        directory = directory.parent_path(); // The trailing separator
+    }
+    for (;;)
+    {
+        const fs::path dot_git = directory / ".git";
+        if (fs::is_directory(dot_git, ec)) {
+            git_directory = dot_git.string();
+            break;
+        }
+        std::string line;
+        if (fs::is_regular_file(dot_git, ec) && ReadFirstLine(dot_git.string(), line) && line.rfind("gitdir: ", 0) == 0)
+        {
+            const fs::path target = line.substr(8);
+            git_directory = (target.is_absolute() ? target : directory / target).string();
+            break;
+        }
+        const fs::path parent = directory.parent_path();
+        if (parent.empty() || parent == directory) {
+            return false;
+        }
+        directory = parent;
+    }
+    work_tree = directory.string();
+
+    common_directory = git_directory;
+    std::string line;
+    if (ReadFirstLine(git_directory + "/commondir", line) && !line.empty())
+    {
+        const fs::path common = line;
+        common_directory = (common.is_absolute() ? common : fs::path(git_directory) / common).string();
+    }
+
+    const std::string objects = common_directory + "/objects";
+    object_directories.push_back(objects);
+    {
+        std::ifstream alternates(objects + "/info/alternates");
+        while (std::getline(alternates, line))
+        {
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            const fs::path alternate = line;
+            object_directories.push_back((alternate.is_absolute() ? alternate : fs::path(objects) / alternate).string());
+        }
+    }
+
+    // Version 2 pack indexes: header, 256-entry fan-out, ids, CRCs, 32-bit offsets,
+    // 64-bit offsets, two checksums.
+    for (const std::string& object_directory : object_directories)
+    {
+        for (fs::directory_iterator it(object_directory + "/pack", ec), end; !ec && it != end; it.increment(ec))
+        {
+            const fs::path index_path = it->path();
+            if (index_path.extension() != ".idx") {
+                continue;
+            }
+            Pack pack;
+            pack.index = MappedFile(index_path.string());
+            const MappedFile& index = pack.index;
+            if (!index.IsValid() || index.Size() < 8 + 1024 + 40 ||
+                std::memcmp(index.Data(), "\377tOc", 4) != 0 || ReadBigEndian32(index.Data() + 4) != 2) {
+                std::cerr << "Skipping unsupported pack index " << index_path.string() << std::endl;
+                continue;
+            }
+            pack.count = ReadBigEndian32(index.Data() + 8 + 255 * 4);
+            if (index.Size() < 8 + 1024 + uint64_t(pack.count) * 28 + 40) {
+                std::cerr << "Skipping damaged pack index " << index_path.string() << std::endl;
+                continue;
+            }
+            fs::path data_path = index_path;
+            data_path.replace_extension(".pack");
+            pack.data = MappedFile(data_path.string());
+            if (!pack.data.IsValid() || pack.data.Size() < 12 || std::memcmp(pack.data.Data(), "PACK", 4) != 0) {
+                std::cerr << "Skipping pack without data " << data_path.string() << std::endl;
+                continue;
+            }
+            packs.push_back(std::move(pack));
+        }
+    }
+
+    std::ifstream packed(common_directory + "/packed-refs");
+    while (std::getline(packed, line))
+    {
+        GitObjectId id;
+        if (line.size() > 41 && line[40] == ' ' && GitObjectId::FromHex(std::string_view(line).substr(0, 40), id)) {
+            packed_refs[line.substr(41)] = id;
+        }
+    }
+    return true;
+}
+
+
+// --- Objects ---
+bool GitRepository::Pack::Find(const GitObjectId& id, uint64_t& offset) const
+{
+    const char* fanout = index.Data() + 8;
+    const uint32_t begin = id.bytes[0] == 0 ? 0 : ReadBigEndian32(fanout + (id.bytes[0] - 1) * 4);
+    const uint32_t end = ReadBigEndian32(fanout + id.bytes[0] * 4);
+    const char* ids = fanout + 1024;
+    uint32_t low = begin, high = std::min(end, count);
+    while (low < high)
+    {
+        const uint32_t middle = low + (high - low) / 2;
+        const int order = std::memcmp(ids + uint64_t(middle) * 20, id.bytes, 20);
+        if (order == 0)
+        {
+            const char* offsets = ids + uint64_t(count) * 24;
+            const uint32_t small = ReadBigEndian32(offsets + uint64_t(middle) * 4);
+            if (!(small & 0x80000000u)) {
+                offset = small;
+                return true;
+            }
+            const uint64_t large_position = uint64_t(count) * 4 + uint64_t(small & 0x7FFFFFFFu) * 8;
+            if (offsets + large_position + 8 > index.Data() + index.Size()) {
+                return false;
+            }
+            offset = uint64_t(ReadBigEndian32(offsets + large_position)) << 32 | ReadBigEndian32(offsets + large_position + 4);
+            return true;
+        }
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return false;
+}
+
+// Follows a chain of deltas down to its base object, then applies them from the
+// base up. Offset deltas stay inside this pack; a reference delta may find its base
+// in any pack, or loose.
+bool GitRepository::ReadPackedObject(const Pack& pack, uint64_t offset, GitObject& object, int depth) const
+{
+    struct Delta
+    {
+        const Pack* pack;
+        uint64_t offset;   // Of the zlib stream
+        uint64_t size;     // Inflated
+    };
+    std::vector<Delta> deltas;
+    const Pack* current = &pack;
+    for (;;)
+    {
+        if (deltas.size() > 10000) {
+            return false; // Far deeper than git ever makes; a loop in a damaged pack
+        }
+        const char* data = current->data.Data();
+        const uint64_t size = current->data.Size();
+        uint64_t pos = offset;
+        if (pos >= size) {
+            return false;
+        }
+        uint8_t byte = static_cast<uint8_t>(data[pos++]);
+        const int type = (byte >> 4) & 7;
+        uint64_t object_size = byte & 15;
+        for (int shift = 4; byte & 0x80; shift += 7)
+        {
+            if (pos >= size || shift > 60) return false;
+            byte = static_cast<uint8_t>(data[pos++]);
+            object_size |= uint64_t(byte & 0x7F) << shift;
+        }
+
+        if (type == 6) // Offset delta: the base is this many bytes further back
+        {
+            if (pos >= size) return false;
+            byte = static_cast<uint8_t>(data[pos++]);
+            uint64_t distance = byte & 0x7F;
+            while (byte & 0x80)
+            {
+                if (pos >= size) return false;
+                byte = static_cast<uint8_t>(data[pos++]);
+                distance = ((distance + 1) << 7) | (byte & 0x7F);
+            }
+            if (distance == 0 || distance > offset) {
+                return false;
+            }
+            deltas.push_back({current, pos, object_size});
+            offset -= distance;
+            continue;
+        }
+        if (type == 7) // Reference delta: the base is named by its id
+        {
+            if (size - pos < 20) return false;
+            GitObjectId base;
+            std::memcpy(base.bytes, data + pos, 20);
+            deltas.push_back({current, pos + 20, object_size});
+            const Pack* base_pack = nullptr;
+            for (const Pack& candidate : packs)
+            {
+                if (candidate.Find(base, offset)) {
+                    base_pack = &candidate;
+                    break;
+                }
+            }
+            if (base_pack) {
+                current = base_pack;
+                continue;
+            }
+            if (depth > 8 || !ReadLooseObject(base, object)) {
+                return false;
+            }
+            break;
+        }
+        if (type < 1 || type > 4 || !Inflate(data + pos, size - pos, object_size, object.data)) {
+            return false;
+        }
+        object.type = static_cast<GitObjectType>(type);
+        break;
+    }
+
+    std::string delta;
+    std::string result;
+    for (auto it = deltas.rbegin(); it != deltas.rend(); ++it)
+    {
+        if (!Inflate(it->pack->data.Data() + it->offset, it->pack->data.Size() - it->offset, it->size, delta) ||
+            !ApplyDelta(object.data, delta, result)) {
+            return false;
+        }
+        object.data.swap(result);
+    }
+    return true;
+}
+
+bool GitRepository::ReadLooseObject(const GitObjectId& id, GitObject& object) const
+{
+    const std::string hex = id.ToHex();
+    for (const std::string& object_directory : object_directories)
+    {
+        MappedFile file(object_directory + "/" + hex.substr(0, 2) + "/" + hex.substr(2));
+        if (!file.IsValid()) {
+            continue;
+        }
+        // "<type> <size>\0" comes first; inflate that far to learn the size, then the rest in place.
+        z_stream stream = {};
+        if (inflateInit(&stream) != Z_OK) {
+            return false;
+        }
+        char header[64];
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(file.Data()));
+        stream.avail_in = static_cast<uInt>(std::min<size_t>(file.Size(), UINT32_MAX));
+        stream.next_out = reinterpret_cast<Bytef*>(header);
+        stream.avail_out = sizeof(header);
+        int result = inflate(&stream, Z_SYNC_FLUSH);
+        const size_t produced = sizeof(header) - stream.avail_out;
+        const char* nul = static_cast<const char*>(std::memchr(header, '\0', produced));
+        const char* space = nul ? static_cast<const char*>(std::memchr(header, ' ', nul - header)) : nullptr;
+        bool ok = (result == Z_OK || result == Z_STREAM_END) && space;
+        if (ok)
+        {
+            object.type = ObjectTypeFromName(std::string_view(header, space - header));
+            const uint64_t size = std::strtoull(space + 1, nullptr, 10);
+            const size_t already = produced - (nul + 1 - header);
+            ok = object.type != GitObjectType::None && already <= size && PlausibleInflatedSize(size, file.Size());
+            if (ok)
+            {
+                try {
+                    object.data.resize(size);
+                } catch (const std::bad_alloc&) {
+                    inflateEnd(&stream);
+                    return false;
+                }
+                std::memcpy(object.data.data(), nul + 1, already);
+                if (result != Z_STREAM_END)
+                {
+                    stream.next_out = reinterpret_cast<Bytef*>(object.data.data() + already);
+                    stream.avail_out = static_cast<uInt>(size - already);
+                    result = inflate(&stream, Z_FINISH);
+                }
+                ok = result == Z_STREAM_END && stream.total_out == (nul + 1 - header) + size;
+            }
+        }
+        inflateEnd(&stream);
+        return ok;
+    }
+    return false;
+}
+
+bool GitRepository::ReadObject(const GitObjectId& id, GitObject& object) const
+{
+    object = GitObject();
+    for (const Pack& pack : packs)
+    {
+        uint64_t offset;
+        if (pack.Find(id, offset)) {
+            return ReadPackedObject(pack, offset, object, 0);
+        }
+    }
+    return ReadLooseObject(id, object);
+}
+
+bool ParseGitTree(std::string_view data, std::vector<GitTreeEntry>& entries)
+{
+    entries.clear();
+    size_t pos = 0;
+    while (pos < data.size())
+    {
+        const size_t space = data.find(' ', pos);
+        const size_t nul = space == std::string_view::npos ? space : data.find('\0', space);
+        if (nul == std::string_view::npos || data.size() - nul - 1 < 20) {
+            return false;
+        }
+        GitTreeEntry entry;
+        for (size_t i = pos; i < space; ++i)
+        {
+            if (data[i] < '0' || data[i] > '7') return false;
+            entry.mode = entry.mode * 8 + (data[i] - '0');
+        }
+        entry.name = data.substr(space + 1, nul - space - 1);
+        std::memcpy(entry.id.bytes, data.data() + nul + 1, 20);
+        entries.push_back(entry);
+        pos = nul + 21;
+    }
+    return true;
+}
+
+
+// --- Revisions ---
+bool GitRepository::ReadRef(const std::string& name, GitObjectId& id, int depth) const
+{
+    if (depth > 10 || name.empty() || name[0] == '/' || name.find("..") != std::string::npos) {
+        return false;
+    }
+    std::string line;
+    if (ReadFirstLine(git_directory + "/" + name, line) || ReadFirstLine(common_directory + "/" + name, line))
+    {
+        if (line.rfind("ref: ", 0) == 0) {
+            return ReadRef(line.substr(5), id, depth + 1);
+        }
+        return GitObjectId::FromHex(std::string_view(line).substr(0, 40), id); // FETCH_HEAD has more after the id
+    }
+    auto packed = packed_refs.find(name);
+    if (packed == packed_refs.end()) {
+        return false;
+    }
+    id = packed->second;
+    return true;
+}
+
+bool GitRepository::ResolveAbbreviation(std::string_view abbreviation, GitObjectId& id, std::string& error) const
+{
+    // Ids are spelled in lower case, in pack indexes and loose directory names alike.
+    std::string hex(abbreviation);
+    std::transform(hex.begin(), hex.end(), hex.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+    std::vector<GitObjectId> found;
+    auto matches = [&](const GitObjectId& candidate) { return candidate.ToHex().compare(0, hex.size(), hex) == 0; };
+
+    GitObjectId low;
+    for (size_t i = 0; i < hex.size(); ++i) {
+        low.bytes[i / 2] |= static_cast<uint8_t>(HexValue(hex[i]) << (i % 2 ? 0 : 4));
+    }
+    for (const Pack& pack : packs)
+    {
+        const char* ids = pack.index.Data() + 8 + 1024;
+        uint32_t first = 0, last = pack.count;
+        while (first < last)
+        {
+            const uint32_t middle = first + (last - first) / 2;
+            if (std::memcmp(ids + uint64_t(middle) * 20, low.bytes, 20) < 0) first = middle + 1;
+            else last = middle;
+        }
+        for (uint32_t i = first; i < pack.count && found.size() < 2; ++i)
+        {
+            GitObjectId candidate;
+            std::memcpy(candidate.bytes, ids + uint64_t(i) * 20, 20);
+            if (!matches(candidate)) break;
+            if (std::find(found.begin(), found.end(), candidate) == found.end()) found.push_back(candidate);
+        }
+    }
+    for (const std::string& object_directory : object_directories)
+    {
+        std::error_code ec;
+        const std::string prefix(hex.substr(0, 2));
+        for (fs::directory_iterator it(object_directory + "/" + prefix, ec), end; !ec && it != end; it.increment(ec))
+        {
+            GitObjectId candidate;
+            if (GitObjectId::FromHex(prefix + it->path().filename().string(), candidate) && matches(candidate) &&
+                std::find(found.begin(), found.end(), candidate) == found.end()) {
+                found.push_back(candidate);
+            }
+        }
+    }
+    if (found.size() != 1) {
+        error = (found.empty() ? "unknown revision: " : "ambiguous revision: ") + std::string(abbreviation);
+        return false;
+    }
+    id = found[0];
+    return true;
+}
+
+// Annotated tags point at another object; follow them down to a commit.
+bool GitRepository::Peel(GitObjectId& id) const
+{
+    for (int depth = 0; depth < 10; ++depth)
+    {
+        GitObject object;
+        if (!ReadObject(id, object)) {
+            return false;
+        }
+        if (object.type == GitObjectType::Commit) {
+            return true;
+        }
+        if (object.type != GitObjectType::Tag || object.data.compare(0, 7, "object ") != 0 ||
+            !GitObjectId::FromHex(std::string_view(object.data).substr(7, 40), id)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+bool GitRepository::Parent(const GitObjectId& commit, int number, GitObjectId& parent) const
+{
+    GitObject object;
+    if (!ReadObject(commit, object) || object.type != GitObjectType::Commit) {
+        return false;
+    }
+    std::string_view rest = object.data;
+    int seen = 0;
+    while (!rest.empty() && rest[0] != '\n')
+    {
+        const size_t end = rest.find('\n');
+        const std::string_view line = rest.substr(0, end);
+        if (line.rfind("parent ", 0) == 0 && ++seen == number) {
+            return GitObjectId::FromHex(line.substr(7), parent);
+        }
+        rest = end == std::string_view::npos ? std::string_view() : rest.substr(end + 1);
+    }
+    return false;
+}
+
+bool GitRepository::ResolveCommit(std::string_view revision, GitObjectId& id, std::string& error) const
+{
+    ZoneScoped;
+    const size_t suffix = revision.find_first_of("~^");
+    const std::string base(revision.substr(0, suffix));
+    bool found = !base.empty() && GitObjectId::FromHex(base, id);
+    static const char* const kRefPatterns[] = {"%s", "refs/%s", "refs/tags/%s", "refs/heads/%s", "refs/remotes/%s", "refs/remotes/%s/HEAD"};
+    for (const char* pattern : kRefPatterns)
+    {
+        if (found || base.empty()) break;
+        std::string name = pattern;
+        name.replace(name.find("%s"), 2, base);
+        found = ReadRef(name, id, 0);
+    }
+    if (!found && base.size() >= 4 && base.size() < 40 && IsHex(base)) {
+        found = ResolveAbbreviation(base, id, error);
+        if (!found) return false;
+    }
+    if (!found) {
+        error = "unknown revision: " + std::string(revision);
+        return false;
+    }
+    if (!Peel(id)) {
+        error = std::string(revision) + " is not a commit, or its objects are missing";
+        return false;
+    }
+
+    // ~N is the Nth first-parent ancestor, ^N the Nth parent; both default to 1.
+    for (size_t pos = suffix; pos < revision.size();)
+    {
+        const char op = revision[pos++];
+        if (op != '~' && op != '^') {
+            error = "cannot parse revision: " + std::string(revision);
+            return false;
+        }
+        int number = 0;
+        bool has_number = false;
+        for (; pos < revision.size() && revision[pos] >= '0' && revision[pos] <= '9' && number < 100000; ++pos) {
+            number = number * 10 + (revision[pos] - '0');
+            has_number = true;
+        }
+        if (!has_number) {
+            number = 1;
+        }
+        const int steps = op == '~' ? number : (number == 0 ? 0 : 1);
+        for (int step = 0; step < steps; ++step)
+        {
+            if (!Parent(id, op == '~' ? 1 : number, id)) {
+                error = std::string(revision) + " goes past the first commit";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool GitRepository::CommitTree(const GitObjectId& commit, GitObjectId& tree) const
+{
+    GitObject object;
+    return ReadObject(commit, object) && object.type == GitObjectType::Commit && object.data.compare(0, 5, "tree ") == 0 &&
+           GitObjectId::FromHex(std::string_view(object.data).substr(5, 40), tree);
+}
+
+
+// --- Index ---
+const GitCacheTree* GitCacheTree::Child(std::string_view child_name) const
+{
+    for (const GitCacheTree& child : children)
+    {
+        if (child.name == child_name) {
+            return &child;
+        }
+    }
+    return nullptr;
+}
+
+// An optionally negative decimal number at p, read no further than `end`: the
+// mapped index is not NUL-terminated, so strtol could run off its end.
+static bool ParseDecimal(const char*& p, const char* end, long& value)
+{
+    const bool negative = p < end && *p == '-';
+    const char* digits = p + (negative ? 1 : 0);
+    const char* q = digits;
+    long result = 0;
+    for (; q < end && *q >= '0' && *q <= '9'; ++q)
+    {
+        if (result > (std::numeric_limits<long>::max() - 9) / 10) {
+            return false;
+        }
+        result = result * 10 + (*q - '0');
+    }
+    if (q == digits) {
+        return false;
+    }
+    value = negative ? -result : result;
+    p = q;
+    return true;
+}
+
+// "<name>\0<entry count> <subtree count>\n" and, unless the count is -1 (invalidated),
+// the tree's id; then its subtrees, depth first.
+static bool ParseCacheTree(const char*& p, const char* end, GitCacheTree& node, int depth)
+{
+    const char* nul = static_cast<const char*>(std::memchr(p, '\0', end - p));
+    if (!nul || depth > 4096) {
+        return false;
+    }
+    node.name.assign(p, nul);
+    p = nul + 1;
+    long entry_count, subtree_count;
+    if (!ParseDecimal(p, end, entry_count) || p >= end || *p++ != ' ' ||
+        !ParseDecimal(p, end, subtree_count) || p >= end || *p++ != '\n' || subtree_count < 0) {
+        return false;
+    }
+    if (entry_count >= 0)
+    {
+        if (end - p < 20) return false;
+        std::memcpy(node.id.bytes, p, 20);
+        node.valid = true;
+        p += 20;
+    }
+    // Each subtree takes at least "\0" "0 0\n", so a count beyond that is damage.
+    if (subtree_count > (end - p) / 5) {
+        return false;
+    }
+    node.children.resize(static_cast<size_t>(subtree_count));
+    for (GitCacheTree& child : node.children)
+    {
+        if (!ParseCacheTree(p, end, child, depth + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool GitRepository::ReadIndex(GitIndex& index, std::string& error) const
+{
+    ZoneScoped;
+    index = GitIndex();
+    const std::string path = git_directory + "/index";
+    MappedFile file(path);
+    if (!file.IsValid()) {
+        return true; // No index yet: nothing is tracked
+    }
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0)
+    {
+        index.mtime_seconds = st.st_mtime;
+#if defined(__APPLE__)
+        index.mtime_nanoseconds = st.st_mtimespec.tv_nsec;
+#elif !defined(_WIN32)
+        index.mtime_nanoseconds = st.st_mtim.tv_nsec;
+#endif
+    }
+
+    const char* data = file.Data();
+    const size_t size = file.Size();
+    if (size < 12 + 20 || std::memcmp(data, "DIRC", 4) != 0) {
+        error = path + " is not a git index";
+        return false;
+    }
+    const uint32_t version = ReadBigEndian32(data + 4);
+    const uint32_t count = ReadBigEndian32(data + 8);
+    if (version < 2 || version > 4) {
+        error = "unsupported index version " + std::to_string(version);
+        return false;
+    }
+    const size_t content_end = size - 20; // A SHA-1 of everything before it closes the file
+    if (count > (content_end - 12) / 62) {
+        error = path + " is damaged: more entries than fit in it";
+        return false;
+    }
+    index.entries.reserve(count);
+    index.paths.reserve(static_cast<size_t>(count) * 32);
+
+    // Fixed fields: ctime, mtime, dev, ino, mode, uid, gid, size, id, flags.
+    size_t pos = 12;
+    std::string previous_path;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (pos > content_end || content_end - pos < 62) {
+            error = path + " is truncated";
+            return false;
+        }
+        const char* fields = data + pos;
+        GitIndexEntry entry;
+        entry.mtime_seconds = ReadBigEndian32(fields + 8);
+        entry.mtime_nanoseconds = ReadBigEndian32(fields + 12);
+        entry.inode = ReadBigEndian32(fields + 20);
+        entry.mode = ReadBigEndian32(fields + 24);
+        entry.size = ReadBigEndian32(fields + 36);
+        std::memcpy(entry.id.bytes, fields + 40, 20);
+        const uint16_t flags = ReadBigEndian16(fields + 60);
+        entry.stage = (flags >> 12) & 3;
+        size_t name_pos = pos + 62;
+        if ((flags & 0x4000) && version >= 3)
+        {
+            if (content_end - name_pos < 2) {
+                error = path + " is truncated in the extended flags of entry " + std::to_string(i);
+                return false;
+            }
+            const uint16_t extended = ReadBigEndian16(data + name_pos);
+            entry.skip_worktree = extended & 0x4000;
+            entry.intent_to_add = extended & 0x2000;
+            name_pos += 2;
+        }
+
+        std::string_view name;
+        if (version == 4)
+        {
+            // The path drops this many bytes from the end of the previous one, then adds the rest.
+            uint64_t strip = 0;
+            uint8_t byte;
+            do {
+                if (name_pos >= content_end) {
+                    error = path + " is truncated in the path of entry " + std::to_string(i);
+                    return false;
+                }
+                byte = static_cast<uint8_t>(data[name_pos++]);
+                strip = (strip << 7) | (byte & 0x7F);
+                if (byte & 0x80) strip++;
+            } while (byte & 0x80);
+            const char* nul = static_cast<const char*>(std::memchr(data + name_pos, '\0', content_end - name_pos));
+            if (!nul || strip > previous_path.size()) {
+                error = path + " is damaged";
+                return false;
+            }
+            previous_path.resize(previous_path.size() - strip);
+            previous_path.append(data + name_pos, nul);
+            name = previous_path;
+            pos = nul + 1 - data;
+        }
+        else
+        {
+            const char* nul = static_cast<const char*>(std::memchr(data + name_pos, '\0', content_end - name_pos));
+            if (!nul) {
+                error = path + " is damaged";
+                return false;
+            }
+            name = std::string_view(data + name_pos, nul - (data + name_pos));
+            pos = (name_pos - pos + name.size() + 8) / 8 * 8 + pos; // NUL-padded to a multiple of 8
+            if (pos > content_end) {
+                error = path + " is truncated in the padding of entry " + std::to_string(i);
+                return false;
+            }
+        }
+        entry.path_offset = static_cast<uint32_t>(index.paths.size());
+        entry.path_length = static_cast<uint32_t>(name.size());
+        index.paths.append(name.data(), name.size());
+        index.entries.push_back(entry);
+    }
+
+    // Extensions: a four-letter signature and a size. Upper case ones are optional.
+    while (pos + 8 <= content_end)
+    {
+        const std::string_view signature(data + pos, 4);
+        const uint32_t extension_size = ReadBigEndian32(data + pos + 4);
+        pos += 8;
+        if (extension_size > content_end - pos) {
+            break;
+        }
+        if (signature == "TREE")
+        {
+            const char* p = data + pos;
+            if (!ParseCacheTree(p, data + pos + extension_size, index.cache_tree, 0)) {
+                index.cache_tree = GitCacheTree(); // Only a shortcut; do without it
+            }
+        }
+        else if (signature == "link")
+        {
+            error = "split indexes are not supported";
+            return false;
+        }
+        pos += extension_size;
+    }
+    return true;
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.h"
+
+// A minimal reader of git repositories: refs, the index, and loose and packed
+// objects, without a git binary or libgit2. SHA-1 repositories only; split
+// indexes are not supported.
+
+struct GitObjectId
+{
+    uint8_t bytes[20] = {};
+
+    bool operator==(const GitObjectId& other) const;
+    bool operator!=(const GitObjectId& other) const { return !(*this == other); }
+    bool operator<(const GitObjectId& other) const;
+    std::string ToHex() const;
+    // Exactly 40 hex digits.
+    static bool FromHex(std::string_view hex, GitObjectId& id);
+};
+
+// SHA-1 of "blob <size>\0" followed by the content: the id git gives a file.
+GitObjectId HashGitBlob(std::string_view content);
+
+enum class GitObjectType : uint8_t
+{
+    None = 0,
+    Commit = 1,
+    Tree = 2,
+    Blob = 3,
+    Tag = 4
+};
+
+struct GitObject
+{
+    GitObjectType type = GitObjectType::None;
+    std::string data;
+};
+
+// File modes as git writes them in trees and the index.
+static constexpr uint32_t kGitModeDirectory = 0040000;
+static constexpr uint32_t kGitModeSymlink = 0120000;
+static constexpr uint32_t kGitModeSubmodule = 0160000;
+
+struct GitTreeEntry
+{
+    uint32_t mode = 0;
+    std::string_view name;   // Into the tree object's data
+    GitObjectId id;
+};
+
+// Splits one tree object into its entries, in git's order. False if it is malformed.
+bool ParseGitTree(std::string_view data, std::vector<GitTreeEntry>& entries);
+
+struct GitIndexEntry
+{
+    uint32_t path_offset = 0;   // Into GitIndex::paths
+    uint32_t path_length = 0;
+    GitObjectId id;
+    uint32_t mode = 0;
+    uint32_t size = 0;          // Truncated to 32 bits, as git stores it
+    uint32_t mtime_seconds = 0;
+    uint32_t mtime_nanoseconds = 0;
+    uint32_t inode = 0;
+    uint8_t stage = 0;          // 1 to 3 while a merge conflict is unresolved
+    bool skip_worktree = false; // Sparse checkouts: not expected in the work tree
+    bool intent_to_add = false; // git add -N: tracked, but nothing staged yet
+};
+
+// A directory of the index's cache tree extension. When valid, `id` is the tree
+// object the index entries below it would be written as, so comparing it with a
+// commit's subtree settles the whole directory without reading it.
+struct GitCacheTree
+{
+    std::string name;
+    bool valid = false;
+    GitObjectId id;
+    std::vector<GitCacheTree> children;
+
+    const GitCacheTree* Child(std::string_view child_name) const;
+};
+
+struct GitIndex
+{
+    std::vector<GitIndexEntry> entries;   // Sorted by path, byte-wise, as git keeps them
+    std::string paths;                    // Relative to the work tree, '/'-separated
+    GitCacheTree cache_tree;
+    int64_t mtime_seconds = 0;            // Of the index file: files changed in that same
+    int64_t mtime_nanoseconds = 0;        // instant may match their stat data and still differ
+
+    std::string_view Path(const GitIndexEntry& entry) const { return std::string_view(paths).substr(entry.path_offset, entry.path_length); }
+};
+
+class GitRepository
+{
+public:
+    // Finds the repository `path` is in: a .git directory in it or one of its parents,
+    // or a .git file pointing at one (linked worktrees, submodules). Packs are mapped
+    // here. Returns false if there is no repository.
+    bool Open(const std::string& path);
+
+    // The directory holding .git, as an absolute path.
+    const std::string& WorkTree() const { return work_tree; }
+
+    // HEAD, branches, tags, remote branches, full or abbreviated hex ids, each with any
+    // number of ~N and ^N suffixes, as git rev-parse reads them. Tags are peeled, and
+    // the result must be a commit.
+    bool ResolveCommit(std::string_view revision, GitObjectId& id, std::string& error) const;
+    // The root tree of a commit.
+    bool CommitTree(const GitObjectId& commit, GitObjectId& tree) const;
+
+    // Inflates an object, loose or packed, with pack deltas applied. Only reads the
+    // mapped files, so any number of threads may call it at once.
+    bool ReadObject(const GitObjectId& id, GitObject& object) const;
+
+    bool ReadIndex(GitIndex& index, std::string& error) const;
+
+private:
+    struct Pack
+    {
+        MappedFile index;
+        MappedFile data;
+        uint32_t count = 0;
+
+        bool Find(const GitObjectId& id, uint64_t& offset) const;
+    };
+
+    bool ReadPackedObject(const Pack& pack, uint64_t offset, GitObject& object, int depth) const;
+    bool ReadLooseObject(const GitObjectId& id, GitObject& object) const;
+    bool ReadRef(const std::string& name, GitObjectId& id, int depth) const;
+    bool ResolveAbbreviation(std::string_view abbreviation, GitObjectId& id, std::string& error) const;
+    bool Peel(GitObjectId& id) const;
+    bool Parent(const GitObjectId& commit, int number, GitObjectId& parent) const;
+
+    std::string work_tree;
+    std::string git_directory;      // HEAD and the index
+    std::string common_directory;   // Objects, refs and packed-refs; shared by linked worktrees
+    std::vector<std::string> object_directories;   // objects/ and its alternates
+    std::vector<Pack> packs;
+    std::map<std::string, GitObjectId, std::less<>> packed_refs;
+};
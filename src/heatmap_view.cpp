@@ -0,0 +1,166 @@
+#include "heatmap_view.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "imgui.h"
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+
+// Hue runs from blue for the smallest cells to red for the biggest one. Cells with
+// nothing selected are washed out, so what would end up in the context stands out.
+static ImU32 HeatColor(double heat, double selected_fraction)
+{
+    float r, g, b;
+    const float hue = 0.66f * (1.0f - static_cast<float>(heat));
+    const float saturation = 0.15f + 0.6f * static_cast<float>(selected_fraction);
+    ImGui::ColorConvertHSVtoRGB(hue, saturation, 0.85f, r, g, b);
+    return IM_COL32(static_cast<int>(r * 255), static_cast<int>(g * 255), static_cast<int>(b * 255), 255);
+}
+
+void HeatmapWindow::Draw(TokenHeatmap& heatmap, SelectionMap& selection, bool* open)
+{
+    ZoneScoped;
+    ImGui::SetNextWindowSize(ImVec2(720.0f, 520.0f), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Token Heatmap", open)) {
+        ImGui::End();
+        return;
+    }
+    const std::shared_ptr<const TreeTotals> totals = heatmap.Totals();
+    if (!totals || totals->nodes.empty())
+    {
+        ImGui::TextDisabled("Counting tokens...");
+        ImGui::End();
+        return;
+    }
+    // Node indices mean nothing in another scan of the tree; start over at its root.
+    if (totals->tree != tree || focus >= totals->nodes.size())
+    {
+        tree = totals->tree;
+        focus = 0;
+        focus_path = tree->root_path;
+    }
+    auto set_focus = [&](uint32_t node) {
+        focus = node;
+        focus_path = tree->Path(node).string();
+    };
+
+    // --- Header: where we are and what it adds up to ---
+    if (focus != 0 && ImGui::SmallButton("Up")) {
+        set_focus(tree->nodes[focus].parent);
+    }
+    ImGui::SameLine();
+    ImGui::TextUnformatted(focus_path.c_str());
+    const SubtreeTotals& focused = totals->nodes[focus];
+    char tokens[32], bytes[32], selected_tokens[32];
+    FormatTokenCount(tokens, sizeof(tokens), focused.tokens);
+    FormatByteCount(bytes, sizeof(bytes), focused.bytes);
+    FormatTokenCount(selected_tokens, sizeof(selected_tokens), focused.selected_tokens);
+    ImGui::Text("%s tokens in %u files (%s), %s selected", tokens, focused.files, bytes, selected_tokens);
+    ImGui::SameLine();
+    int metric_index = static_cast<int>(metric);
+    ImGui::RadioButton("All", &metric_index, static_cast<int>(TreemapMetric::AllTokens));
+    ImGui::SameLine();
+    ImGui::RadioButton("Selected", &metric_index, static_cast<int>(TreemapMetric::SelectedTokens));
+    metric = static_cast<TreemapMetric>(metric_index);
+    if (heatmap.IsRunning())
+    {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(updating)");
+    }
+
+    // --- Treemap ---
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+    const ImVec2 size = ImGui::GetContentRegionAvail();
+    if (size.x < 1.0f || size.y < 1.0f) {
+        ImGui::End();
+        return;
+    }
+    heatmap.RequestLayout(focus, size.x, size.y, metric);
+    ImGui::InvisibleButton("##treemap", size);
+    const bool hovered = ImGui::IsItemHovered();
+
+    // While a new layout is computed the previous one is stretched to fit, as long
+    // as it belongs to the same tree and directory.
+    const std::shared_ptr<const TreemapLayout> layout = heatmap.Layout();
+    if (!layout || layout->totals->tree != tree || layout->focus != focus || layout->width <= 0.0f || layout->height <= 0.0f) {
+        ImGui::End();
+        return;
+    }
+    const float scale_x = size.x / layout->width;
+    const float scale_y = size.y / layout->height;
+    const std::vector<SubtreeTotals>& cell_totals = layout->totals->nodes;
+
+    uint64_t biggest = 1;
+    for (const TreemapCell& cell : layout->cells)
+    {
+        const SubtreeTotals& t = cell_totals[cell.node];
+        biggest = std::max(biggest, metric == TreemapMetric::AllTokens ? t.tokens : t.selected_tokens);
+    }
+
+    ImDrawList* draw_list = ImGui::GetWindowDrawList();
+    const ImVec2 mouse = ImGui::GetMousePos();
+    const TreemapCell* hovered_cell = nullptr;
+    for (const TreemapCell& cell : layout->cells)
+    {
+        const ImVec2 min(origin.x + cell.x * scale_x, origin.y + cell.y * scale_y);
+        const ImVec2 max(min.x + cell.width * scale_x, min.y + cell.height * scale_y);
+        const SubtreeTotals& t = cell_totals[cell.node];
+        const uint64_t value = metric == TreemapMetric::AllTokens ? t.tokens : t.selected_tokens;
+        // Square root, so mid-sized cells are still told apart from the tiny ones.
+        const double heat = std::sqrt(static_cast<double>(value) / biggest);
+        const double selected_fraction = t.tokens > 0 ? static_cast<double>(t.selected_tokens) / t.tokens : 0.0;
+        draw_list->AddRectFilled(min, max, HeatColor(heat, selected_fraction));
+        draw_list->AddRect(min, max, IM_COL32(0, 0, 0, 160));
+
+        const std::string_view name = tree->Name(cell.node);
+        if (max.x - min.x > 24.0f && max.y - min.y > ImGui::GetTextLineHeight())
+        {
+            draw_list->PushClipRect(min, max, true);
+            draw_list->AddText(ImVec2(min.x + 3.0f, min.y + 1.0f), IM_COL32(0, 0, 0, 255), name.data(), name.data() + name.size());
+            draw_list->PopClipRect();
+        }
+        // Nested cells come after their parent, so the last hit is the innermost.
+        if (hovered && mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y) {
+            hovered_cell = &cell;
+        }
+    }
+
+    if (hovered_cell)
+    {
+        const uint32_t node = hovered_cell->node;
+        const SubtreeTotals& t = cell_totals[node];
+        FormatTokenCount(tokens, sizeof(tokens), t.tokens);
+        FormatByteCount(bytes, sizeof(bytes), t.bytes);
+        FormatTokenCount(selected_tokens, sizeof(selected_tokens), t.selected_tokens);
+        const std::string_view name = tree->Name(node);
+        ImGui::SetTooltip("%.*s\n%s tokens, %s, %u files\n%s tokens selected\n%s", static_cast<int>(name.size()), name.data(),
+                          tokens, bytes, t.files, selected_tokens,
+                          tree->nodes[node].is_directory ? "Click to open, right-click to toggle selection" : "Right-click to toggle selection");
+
+        if (ImGui::IsItemClicked(ImGuiMouseButton_Left) && tree->nodes[node].is_directory) {
+            set_focus(node);
+        }
+        if (ImGui::IsItemClicked(ImGuiMouseButton_Right))
+        {
+            // Fully selected cells are dropped; anything else is selected completely.
+            // Asked of the selection itself, not the token totals, so empty files toggle too.
+            const fs::path path = tree->Path(node);
+            const std::string path_string = path.string();
+            if (tree->nodes[node].is_directory)
+            {
+                const bool select = CalculateAndCacheDirectoryState(*tree, node, path_string, selection) != SelectionState::FullySelected;
+                SetSelectionRecursively(*tree, node, path, select, selection);
+            }
+            else
+            {
+                auto entry = selection.find(path_string);
+                selection[path_string] = entry == selection.end() || !entry->second;
+            }
+            InvalidateParentCaches(path);
+        }
+    }
+    ImGui::End();
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "selection.h"
+#include "token_heatmap.h"
+
+// Treemap window over a TokenHeatmap: every directory and file of the focused
+// directory is a cell sized by its tokens, and the biggest contributors glow red.
+// Click a directory to zoom in, right-click any cell to drop it from (or add it to)
+// the selection. The layout is computed by the heatmap's worker threads; drawing
+// just walks the finished cells.
+class HeatmapWindow
+{
+public:
+    void Draw(TokenHeatmap& heatmap, SelectionMap& selection, bool* open);
+
+private:
+    std::shared_ptr<const FileTree> tree;   // Tree `focus` indexes into
+    uint32_t focus = 0;
+    std::string focus_path;
+    TreemapMetric metric = TreemapMetric::AllTokens;
+};
@@ -9,370 +9,185 @@
 #include <fstream>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
 
 #include <filesystem>
 #include <iostream>
 
-// --- Tracy Profiler ---
-#include "tracy/Tracy.hpp"
+#include "file_tree.h"
+#include "fuzzy_finder.h"
+#include "content_search.h"
+#include "context_export.h"
+#include "context_generator.h"
+#include "context_server.h"
+#include "git_changes.h"
+#include "projects.h"
+#include "selection.h"
+#include "tree_view.h"
+#include "frame_arena.h"
+#include "heatmap_view.h"
+#include "metrics.h"
+#include "perf_overlay.h"
 
-#include "nlohmann/json.hpp"
+// --- Tracy Profiler ---
+#include "profiling.h"
 
 namespace fs = std::filesystem;
-using json = nlohmann::json;
-
 
 
-struct Project
-{
-    std::string name;
-    std::string root_path;
-    std::vector<std::string> selected_paths;
-};
-
-enum class SelectionState {
-    NotSelected,
-    PartiallySelected,
-    FullySelected
-};
-
 
 // This vector will hold all loaded projects.
 static std::vector<Project> projects;
-static std::map<std::string, SelectionState> directory_state_cache;
-
-
-
 
-// A recursive helper to determine the state without re-iterating the directory structure multiple times.
-void CheckChildrenState(const fs::path& path, const std::map<std::string, bool>& selection, bool& found_selected, bool& found_unselected)
-{
-    // Stop if we've already found both states, no need to check further.
-    if (found_selected && found_unselected) {
-        return;
-    }
 
-    for (const auto& entry : fs::directory_iterator(path))
-    {
-        try {
-            std::string entry_path_str = entry.path().string();
-            if (entry.is_directory())
-            {
-                CheckChildrenState(entry.path(), selection, found_selected, found_unselected);
-            }
-            else // It's a file
-            {
-                // Check if the file is in the selection map and if it's selected
-                if (selection.count(entry_path_str) && selection.at(entry_path_str)) {
-                    found_selected = true;
-                } else {
-                    found_unselected = true;
-                }
-            }
-        } catch (std::exception e) {
-            std::cerr << "Filesystem error: " << e.what() << std::endl;
-            continue;
-        }
-    }
-}
+// Startup budget: the first frame must not wait on projects.json or the disk scan.
+static constexpr double kFirstFrameBudgetMs = 50.0;
 
-SelectionState GetDirectorySelectionState(const fs::path& path, const std::map<std::string, bool>& selection)
+static double MillisecondsSince(std::chrono::steady_clock::time_point start)
 {
-    bool found_selected = false;
-    bool found_unselected = false;
-
-    try {
-        if (!fs::exists(path) || !fs::is_directory(path) || fs::is_empty(path)) {
-            // An empty directory can't be partially selected.
-            // We check its own state in the selection map.
-            return selection.count(path.string()) && selection.at(path.string()) ? SelectionState::FullySelected : SelectionState::NotSelected;
-        }
-        CheckChildrenState(path, selection, found_selected, found_unselected);
-    } catch (const fs::filesystem_error& e) {
-        // Handle potential permission errors gracefully
-        return SelectionState::NotSelected;
-    }
-
-    if (found_selected && found_unselected) {
-        return SelectionState::PartiallySelected;
-    }
-    if (found_selected) {
-        return SelectionState::FullySelected;
-    }
-    return SelectionState::NotSelected;
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
 
+// Startup timings go to Tracy; --startup-timings also prints them, for measuring
+// without the profiler attached.
+static bool print_startup_timings = false;
 
-
-void SaveProjects()
+static void ReportStartup(const char* message)
 {
-    ZoneScoped;
-    json j;
-    for (const auto& p : projects)
-    {
-        j["projects"].push_back({
-            {"name", p.name},
-            {"root_path", p.root_path},
-            {"selected_paths", p.selected_paths}
-        });
+    TracyMessage(message, strlen(message));
+    if (print_startup_timings) {
+        printf("%s\n", message);
     }
-
-    std::ofstream o("projects.json");
-    o << std::setw(4) << j << std::endl;
 }
 
-void LoadProjects()
+static void ReportStartupMilestone(const char* name, double ms)
 {
-    ZoneScoped;
-    projects.clear();
-    std::ifstream i("projects.json");
-    if (!i.is_open()) {
-        return; // No projects file yet, which is fine.
-    }
-
-    json j;
-    i >> j;
-
-    if (j.contains("projects"))
-    {
-        for (const auto& item : j["projects"])
-        {
-            Project p;
-            p.name = item.value("name", "Unnamed");
-            p.root_path = item.value("root_path", ".");
-            if (item.contains("selected_paths")) {
-                p.selected_paths = item["selected_paths"].get<std::vector<std::string>>();
-            }
-            projects.push_back(p);
-        }
-    }
+    char message[128];
+    snprintf(message, sizeof(message), "%s: %.1f ms", name, ms);
+    ReportStartup(message);
 }
 
-
-void SetSelectionRecursively(const fs::path& path, bool selected, std::map<std::string, bool>& selection)
+// --- Idle rendering ---
+// The main loop sleeps in SDL_WaitEventTimeout while nothing changes. Input wakes it,
+// and so do background jobs, by pushing wake_event when they have a result.
+static constexpr int kGraceFrames = 3;      // Frames drawn after a change, for ImGui's hover/fade/nav updates
+static constexpr int kBusyPollMs = 100;     // Longest sleep while jobs are pending, in case a wake-up was missed
+static constexpr int kCursorBlinkMs = 500;  // Redraw rate while a text field has focus
+static std::atomic<Uint32> wake_event{static_cast<Uint32>(-1)};
+
+// Safe from any thread. Before SDL is initialised this does nothing; the loop's
+// busy polling picks up those early results instead.
+static void WakeMainLoop()
 {
-    selection[path.string()] = selected;
-    directory_state_cache.erase(path.string()); // Invalidate this directory's cache
-
-    if (fs::is_directory(path))
+    const Uint32 type = wake_event.load();
+    if (type != static_cast<Uint32>(-1))
     {
-        for (const auto& entry : fs::directory_iterator(path))
-        {
-            SetSelectionRecursively(entry.path(), selected, selection);
-        }
+        SDL_Event event = {};
+        event.type = type;
+        SDL_PushEvent(&event);
     }
 }
 
-
-void InvalidateParentCaches(const fs::path& path)
+// --- Workspace roots ---
+// Two spellings of one directory ("." and its absolute path, or a symlink to it)
+// should be scanned once, so roots are compared after resolving them.
+static fs::path ResolvedRoot(const std::string& root)
 {
-    fs::path current = path;
-    while (current.has_parent_path())
-    {
-        fs::path parent = current.parent_path();
-
-        // Break condition: if the parent is the same as the current path,
-        // we have reached the root (e.g., "D:\"'s parent is "D:\").
-        if (parent == current) {
-            break;
-        }
-
-        directory_state_cache.erase(parent.string());
-        current = parent;
-    }
+    std::error_code ec;
+    fs::path resolved = fs::weakly_canonical(root, ec);
+    return ec ? fs::path(root) : resolved;
 }
-SelectionState CalculateAndCacheDirectoryState(const fs::path& path, const std::map<std::string, bool>& selection)
-{
-    ZoneScoped;
-    try {
-        std::string path_str = path.string();
-
-        // 1. Check cache first - This is the key optimization!
-        if (directory_state_cache.count(path_str))
-        {
-            return directory_state_cache.at(path_str);
-        }
-
-        // --- If not in cache, calculate it ---
-        bool found_selected = false;
-        bool found_unselected = false;
-
-        try
-        {
-            if (fs::is_empty(path)) {
-                // Base case for empty directory
-                directory_state_cache[path_str] = SelectionState::NotSelected;
-                return SelectionState::NotSelected;
-            }
 
-            for (const auto& entry : fs::directory_iterator(path))
-            {
-                ZoneScopedN("Cache Calculation Iteration");
-                if (found_selected && found_unselected) break; // Early exit
-
-                if (entry.is_directory())
-                {
-                    // Recursively call this function to ensure children are cached
-                    SelectionState child_state = CalculateAndCacheDirectoryState(entry.path(), selection);
-                    if (child_state != SelectionState::NotSelected) found_selected = true;
-                    if (child_state != SelectionState::FullySelected) found_unselected = true;
-                }
-                else // It's a file
-                {
-                    if (selection.count(entry.path().string()) && selection.at(entry.path().string())) {
-                        found_selected = true;
-                    } else {
-                        found_unselected = true;
-                    }
-                }
-            }
-        }
-        catch (const fs::filesystem_error&) { /* Ignore errors */ }
-
-        SelectionState result = SelectionState::NotSelected;
-        if (found_selected && found_unselected) {
-            result = SelectionState::PartiallySelected;
-        } else if (found_selected) {
-            result = SelectionState::FullySelected;
-        }
-
-        // 2. Store the result in the cache before returning
-        directory_state_cache[path_str] = result;
-        return result;
-    }  catch (std::exception e) {
-        std::cerr << "Error calculating directory state: " << e.what() << std::endl;
-        return SelectionState::NotSelected;
-    }
-}
-
-void DrawDirectoryTree(const fs::path& path, std::map<std::string, bool>& selection)
+// Main application loop
+int main(int argc, char** argv)
 {
-    ZoneScoped;
-    std::vector<fs::directory_entry> directories;
-    std::vector<fs::directory_entry> files;
-
-    // Separate directories and files to display directories first
-    try {
-        for (const auto& entry : fs::directory_iterator(path))
-        {
-            if (entry.is_directory()) {
-                directories.push_back(entry);
-            } else {
-                files.push_back(entry);
-            }
+    const auto startup_begin = std::chrono::steady_clock::now();
+
+    // --serve (or --serve=PATH) answers editor and script requests while the app runs,
+    // reusing the tree the UI has already scanned. See context_server.h.
+    // --startup-timings prints how long the first frame and interactivity took.
+    // Any other argument names an exported .zst context to open in the viewer.
+    ContextServer context_server;
+    std::string open_context_path;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if (arg == "--serve") {
+            context_server.Start(DefaultServerSocketPath());
+        } else if (arg.rfind("--serve=", 0) == 0) {
+            context_server.Start(std::string(arg.substr(8)));
+        } else if (arg == "--startup-timings") {
+            print_startup_timings = true;
+        } else if (arg.rfind("--", 0) != 0) {
+            open_context_path = arg;
         }
-    } catch (const fs::filesystem_error& e) {
-        ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Error accessing %s", path.string().c_str());
-        return;
     }
 
-
-    // Sort both lists alphabetically
-    std::sort(directories.begin(), directories.end(), [](const auto& a, const auto& b) {
-        return a.path().filename() < b.path().filename();
-    });
-    std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) {
-        return a.path().filename() < b.path().filename();
+    // Kick off the slow parts of startup right away; they finish while SDL and GL initialise.
+    std::future<std::vector<Project>> projects_loading = std::async(std::launch::async, [] {
+        std::vector<Project> loaded = LoadProjects();
+        WakeMainLoop();
+        return loaded;
     });
-
-    // --- Render Directories with 3-state logic ---
-    for (const auto& entry : directories)
-    {
-        auto filename = entry.path().filename().string();
-        SelectionState state = CalculateAndCacheDirectoryState(entry.path(), selection);
-
-        const char* icon = "[ ]";
-        if (state == SelectionState::FullySelected) {
-            icon = "[X]"; // Use a capital X instead of ✓
-        } else if (state == SelectionState::PartiallySelected) {
-            icon = "[~]";
-        }
-
-        ImGui::TextUnformatted(icon);
-        ImGui::SameLine();
-
-        // Make the icon clickable
-        ImGui::SetCursorPosX(ImGui::GetCursorPosX() - ImGui::CalcTextSize(icon).x - ImGui::GetStyle().ItemSpacing.x);
-        if (ImGui::InvisibleButton(filename.c_str(), ImGui::CalcTextSize(icon)))
+    BackgroundScan scan;
+    scan.SetUpdateCallback(WakeMainLoop);
+    static char path_buffer[1024] = ".";
+    scan.Start(path_buffer);
+
+    // Additional roots of the workspace. Each has its own scan, running in parallel
+    // with the main one; roots that resolve to a directory already in the workspace
+    // are skipped. Selections from every root go into the same generated context.
+    static std::vector<std::string> extra_roots;
+    static LinkPolicy link_policy = LinkPolicy::Follow;
+    std::vector<std::unique_ptr<BackgroundScan>> extra_scans;
+    auto start_extra_scans = [&]() {
+        extra_scans.clear();
+        std::vector<fs::path> scanned = {ResolvedRoot(path_buffer)};
+        for (const auto& root : extra_roots)
         {
-            // When clicked, a partial or unselected folder becomes fully selected.
-            // A fully selected folder becomes unselected.
-            bool new_selection_state = (state == SelectionState::NotSelected);
-            SetSelectionRecursively(entry.path(), new_selection_state, selection);
-            InvalidateParentCaches(entry.path());
+            fs::path resolved = ResolvedRoot(root);
+            if (std::find(scanned.begin(), scanned.end(), resolved) != scanned.end()) {
+                continue;
+            }
+            scanned.push_back(resolved);
+            auto extra_scan = std::make_unique<BackgroundScan>();
+            extra_scan->SetUpdateCallback(WakeMainLoop);
+            extra_scan->SetLinkPolicy(link_policy);
+            extra_scan->Start(root);
+            extra_scans.push_back(std::move(extra_scan));
         }
-        ImGui::SameLine();
-        // --- End of Custom Checkbox ---
-
-        if (ImGui::TreeNode(filename.c_str()))
-        {
-            DrawDirectoryTree(entry.path(), selection);
-            ImGui::TreePop();
+    };
+    auto workspace_roots = [&]() {
+        std::vector<std::string> roots = {path_buffer};
+        roots.insert(roots.end(), extra_roots.begin(), extra_roots.end());
+        return roots;
+    };
+    // The latest tree of every root, the main one first. Roots still on their first
+    // scan have none yet and are left out.
+    auto workspace_trees = [&]() {
+        std::vector<std::shared_ptr<const FileTree>> trees;
+        if (std::shared_ptr<const FileTree> tree = scan.Tree()) {
+            trees.push_back(std::move(tree));
         }
-    }
-
-    // --- Render Files with normal checkbox ---
-    for (const auto& entry : files)
-    {
-        std::string path_string = entry.path().string();
-        auto filename = entry.path().filename().string();
-        bool& is_selected = selection[path_string];
-
-        // Choose the icon based on the file's selection state
-        const char* icon = is_selected ? "[X]" : "[ ]";
-
-        ImGui::TextUnformatted(icon);
-        ImGui::SameLine();
-
-        // Make the icon clickable to toggle selection
-        ImGui::SetCursorPosX(ImGui::GetCursorPosX() - ImGui::CalcTextSize(icon).x - ImGui::GetStyle().ItemSpacing.x);
-        // Use the path_string for a unique ID for the InvisibleButton
-        if (ImGui::InvisibleButton(path_string.c_str(), ImGui::CalcTextSize(icon)))
+        for (const auto& extra_scan : extra_scans)
         {
-            is_selected = !is_selected;
-            InvalidateParentCaches(entry.path());
-        }
-        ImGui::SameLine();
-
-        // Display the filename as simple text
-        ImGui::TextUnformatted(filename.c_str());
-    }
-}
-
-void GenerateContext(const std::map<std::string, bool>& selection, std::string& aggregated_text, int& file_count, int& token_count)
-{
-    ZoneScoped;
-    aggregated_text.clear();
-    file_count = 0;
-    token_count = 0;
-
-    for (const auto& [path, selected] : selection)
-    {
-        if (selected && fs::is_regular_file(path))
-        {
-            std::ifstream file(path);
-            if (file.is_open())
-            {
-                std::string file_content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-                aggregated_text += "--- " + path + " ---\n";
-                aggregated_text += file_content;
-                aggregated_text += "\n";
-                file_count++;
-                token_count += file_content.length() / 4; // Simple token approximation
+            if (std::shared_ptr<const FileTree> tree = extra_scan->Tree()) {
+                trees.push_back(std::move(tree));
             }
         }
-    }
-}
+        return trees;
+    };
 
-// Main application loop
-int main(int, char**)
-{
     // --- Setup SDL ---
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_GAMECONTROLLER) != 0)
     {
         printf("Error: %s\n", SDL_GetError());
         return -1;
     }
+    wake_event = SDL_RegisterEvents(1);
 
     // Decide GL+GLSL versions
 #if defined(IMGUI_IMPL_OPENGL_ES2)
@@ -424,31 +239,226 @@ int main(int, char**)
     // Our state
     ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
     std::string aggregated_text;
-    static char path_buffer[1024] = ".";
-    static std::map<std::string, bool> selection;
-    int file_count = 0;
-    int token_count = 0;
+    static SelectionMap selection;
+    static ContextOptions context_options;
+    ContextStats context_stats;
+    std::string export_status;
+    // A .zst export reads the whole selection, so like a content search it runs on a
+    // worker thread, against a copy of the selection taken when it started.
+    struct ExportResult
+    {
+        bool exported = false;
+        ContextStats stats;
+        CompressedExportStats export_stats;
+    };
+    std::future<ExportResult> context_export;
+    // Delta contexts are taken against the snapshot file; saving the snapshot of the
+    // context in the viewer marks it as sent.
+    static char snapshot_buffer[1024] = "context.snapshot";
+    ContextSnapshot generated_snapshot;
+    std::string snapshot_status;
+    auto options_with_snapshot = [&](ContextSnapshot& since) {
+        ContextOptions options = context_options;
+        if (options.delta != DeltaMode::Off)
+        {
+            if (LoadContextSnapshot(snapshot_buffer, since)) {
+                options.since = &since;
+                snapshot_status = "Against the snapshot of " + std::to_string(since.files.size()) + " files";
+            } else {
+                snapshot_status = std::string("No snapshot at ") + snapshot_buffer + ", every file counts as added";
+            }
+        }
+        return options;
+    };
+    // Without a revision, files are read from the disk; with one, as that commit has
+    // them. False if the revision cannot be read, with the reason in source_status.
+    static char revision_buffer[256] = "";
+    std::string source_status;
+    auto open_source = [&](GitCommitSource& source, ContextOptions& options) {
+        source_status.clear();
+        if (revision_buffer[0] == '\0') {
+            return true;
+        }
+        if (!source.Open(workspace_roots(), revision_buffer, source_status)) {
+            return false;
+        }
+        options.source = &source;
+        return true;
+    };
+    auto open_compressed_context = [&](const std::string& path) {
+        context_stats = {};
+        generated_snapshot.files.clear();
+        export_status = LoadCompressedContext(path, aggregated_text)
+            ? "Opened " + path + " (" + std::to_string(aggregated_text.size() >> 10) + " KiB)"
+            : "Could not open " + path + ", see the console";
+    };
+    if (!open_context_path.empty()) {
+        open_compressed_context(open_context_path);
+    }
 
-    LoadProjects();
+    // Quick-open state. There is an index per root, built on a worker thread whenever
+    // the workspace's trees are not the ones the indexes were built from.
+    static char find_buffer[256] = "";
+    std::future<std::vector<std::shared_ptr<const FuzzyIndex>>> fuzzy_index_building;
+    std::vector<std::shared_ptr<const FuzzyIndex>> fuzzy_indexes;   // In workspace_trees() order
+    std::vector<std::vector<FuzzyMatch>> find_results;              // Per index
+    size_t find_match_count = 0;
+    double find_ms = 0.0;
+    bool find_dirty = false;
+    auto fuzzy_indexes_current = [&](const std::vector<std::shared_ptr<const FileTree>>& trees) {
+        return std::equal(trees.begin(), trees.end(), fuzzy_indexes.begin(), fuzzy_indexes.end(),
+                          [](const auto& tree, const auto& index) { return index->tree == tree; });
+    };
+
+    // Content search state. Searches run on worker threads against the trees they started
+    // with, one root after another.
+    static char search_buffer[256] = "";
+    static bool search_regex = false;
+    static bool search_ignore_case = false;
+    std::future<std::vector<ContentSearchResult>> content_search;
+    auto content_search_cancel = std::make_shared<std::atomic<bool>>(false);
+    std::vector<std::shared_ptr<const FileTree>> search_trees;
+    std::vector<ContentSearchResult> search_results;   // Per tree; stops at the first error
+    auto search_begin = std::chrono::steady_clock::now();
+    double search_ms = 0.0;
+
+    // Git changes state. Like a content search, a lookup runs against the trees it started
+    // with; each root is looked up in whatever repository it belongs to.
+    static bool git_worktree = true;
+    static bool git_staged = true;
+    static char git_since_buffer[256] = "";
+    std::future<std::vector<GitChangesResult>> git_lookup;
+    std::vector<std::shared_ptr<const FileTree>> git_trees;
+    std::vector<GitChangesResult> git_results;   // Per tree
+    auto git_begin = std::chrono::steady_clock::now();
+    double git_ms = 0.0;
+
+    PerfOverlay perf_overlay;
+    bool show_perf_overlay = false;
+    // Token totals of the main tree, for the tree view and the heatmap window. Additional
+    // roots are drawn without totals and are not mapped.
+    TokenHeatmap token_heatmap;
+    token_heatmap.SetUpdateCallback(WakeMainLoop);
+    HeatmapWindow heatmap_window;
+    bool show_heatmap = false;
 
     // --- Main loop ---
     bool done = false;
+    bool first_frame_presented = false;
+    bool interactive = false;
+    int frames_to_draw = kGraceFrames;
+    auto handle_event = [&](const SDL_Event& event) {
+        ImGui_ImplSDL2_ProcessEvent(&event);
+        if (event.type == SDL_QUIT)
+            done = true;
+        if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_CLOSE && event.window.windowID == SDL_GetWindowID(window))
+            done = true;
+        frames_to_draw = kGraceFrames;
+    };
     while (!done)
     {
+        ZoneNamedN(first_frame_zone, "First Frame", !first_frame_presented);
         SDL_Event event;
+
+        // Nothing changed for a few frames: sleep until input or a background job wakes us.
+        // The perf overlay keeps the loop running so its frame times stay meaningful.
+        const bool extra_scans_running = std::any_of(extra_scans.begin(), extra_scans.end(), [](const auto& s) { return s->IsRunning(); });
+        const bool jobs_pending = projects_loading.valid() || scan.IsRunning() || extra_scans_running || fuzzy_index_building.valid() || content_search.valid() ||
+                                  git_lookup.valid() || context_export.valid() || token_heatmap.IsRunning();
+        if (frames_to_draw <= 0 && !show_perf_overlay)
+        {
+            ZoneNamedN(idle_zone, "Idle", true);
+            const int timeout_ms = jobs_pending ? kBusyPollMs : io.WantTextInput ? kCursorBlinkMs : -1;
+            if (SDL_WaitEventTimeout(&event, timeout_ms)) {
+                handle_event(event);
+            }
+        }
         while (SDL_PollEvent(&event))
         {
-            ImGui_ImplSDL2_ProcessEvent(&event);
-            if (event.type == SDL_QUIT)
-                done = true;
-            if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_CLOSE && event.window.windowID == SDL_GetWindowID(window))
-                done = true;
+            handle_event(event);
         }
+        if (frames_to_draw > 0) frames_to_draw--;
 
         // Start the Dear ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplSDL2_NewFrame();
         ImGui::NewFrame();
+        perf_overlay.NewFrame();
+
+        // --- Pick up background startup work ---
+        {
+            ZoneNamedN(poll_zone, "Poll Background Work", true);
+            if (projects_loading.valid() && projects_loading.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            {
+                projects = projects_loading.get();
+            }
+            if (scan.Poll())
+            {
+                // The directory set may have changed, so cached tri-states are stale.
+                directory_state_cache.clear();
+                if (context_server.IsRunning()) {
+                    context_server.ShareTree(scan.Tree());
+                }
+            }
+            for (auto& extra_scan : extra_scans)
+            {
+                if (extra_scan->Poll())
+                {
+                    directory_state_cache.clear();
+                    if (context_server.IsRunning()) {
+                        context_server.ShareTree(extra_scan->Tree());
+                    }
+                }
+            }
+            token_heatmap.Poll(scan.Tree(), selection);
+            if (fuzzy_index_building.valid() && fuzzy_index_building.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            {
+                fuzzy_indexes = fuzzy_index_building.get();
+                find_dirty = true;
+            }
+            // A build still running is left to finish: assigning over its future would
+            // block this frame in the old future's destructor until it did. Once it is
+            // picked up, any root that rescanned or was added meanwhile is indexed.
+            std::vector<std::shared_ptr<const FileTree>> trees = workspace_trees();
+            if (!fuzzy_index_building.valid() && !fuzzy_indexes_current(trees))
+            {
+                fuzzy_index_building = std::async(std::launch::async, [trees = std::move(trees), previous = fuzzy_indexes]() {
+                    std::vector<std::shared_ptr<const FuzzyIndex>> indexes;
+                    for (const auto& tree : trees)
+                    {
+                        // Roots that did not rescan keep their index.
+                        auto kept = std::find_if(previous.begin(), previous.end(), [&](const auto& index) { return index->tree == tree; });
+                        indexes.push_back(kept != previous.end() ? *kept : BuildFuzzyIndex(tree));
+                    }
+                    WakeMainLoop();
+                    return indexes;
+                });
+            }
+            if (content_search.valid() && content_search.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            {
+                search_results = content_search.get();
+                search_ms = MillisecondsSince(search_begin);
+            }
+            if (git_lookup.valid() && git_lookup.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            {
+                git_results = git_lookup.get();
+                git_ms = MillisecondsSince(git_begin);
+            }
+            if (context_export.valid() && context_export.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            {
+                const ExportResult result = context_export.get();
+                context_stats = result.stats;
+                export_status = result.exported
+                    ? "Exported " + std::to_string(result.export_stats.uncompressed_bytes >> 10) + " KiB as " +
+                      std::to_string(result.export_stats.compressed_bytes >> 10) + " KiB"
+                    : "Export failed, see the console";
+            }
+            if (!interactive && first_frame_presented && !projects_loading.valid() && !scan.IsRunning())
+            {
+                interactive = true;
+                ReportStartupMilestone("Time to interactive", MillisecondsSince(startup_begin));
+            }
+        }
 
         // --- Main Application Window ---
         {
@@ -461,6 +471,13 @@ int main(int, char**)
 
              {
                 ImGui::Text("Projects");
+                // Saving before projects.json has been read would overwrite it with an empty list.
+                const bool projects_pending = projects_loading.valid();
+                if (projects_pending) {
+                    ImGui::SameLine();
+                    ImGui::TextDisabled("(loading...)");
+                }
+                ImGui::BeginDisabled(projects_pending);
 
                 static int current_project_idx = -1;
 				static char project_name_buffer[128] = "";
@@ -476,13 +493,18 @@ int main(int, char**)
 					if (current_project_idx >= 0 && current_project_idx < projects.size())
 					{
 						const auto& p = projects[current_project_idx];
-						strncpy_s(path_buffer, p.root_path.c_str(), sizeof(path_buffer) - 1);
+						strncpy_s(path_buffer, p.root_paths[0].c_str(), sizeof(path_buffer) - 1);
+						extra_roots.assign(p.root_paths.begin() + 1, p.root_paths.end());
 						strncpy_s(project_name_buffer, p.name.c_str(), sizeof(project_name_buffer) - 1);
 
 						selection.clear();
 						for (const auto& path : p.selected_paths) {
 							selection[path] = true;
 						}
+						directory_state_cache.clear();
+						selection_generation++;
+						scan.Start(path_buffer);
+						start_extra_scans();
 					}
                 }
 
@@ -492,7 +514,7 @@ int main(int, char**)
                     if (current_project_idx >= 0 && current_project_idx < projects.size())
                     {
                         projects.erase(projects.begin() + current_project_idx);
-                        SaveProjects();
+                        SaveProjects(projects);
                         current_project_idx = -1; // Reset selection
 						project_name_buffer[0] = '\0'; // Clear buffer
                     }
@@ -511,7 +533,7 @@ int main(int, char**)
 						{
 							// Overwrite existing project
 							Project& p = projects[current_project_idx];
-							p.root_path = path_buffer;
+							p.root_paths = workspace_roots();
 							p.selected_paths.clear();
 							for (const auto& [path, selected] : selection)
 							{
@@ -529,7 +551,7 @@ int main(int, char**)
 
 							if (it != projects.end()) {
 								// A project with this name already exists, update it
-								it->root_path = path_buffer;
+								it->root_paths = workspace_roots();
 								it->selected_paths.clear();
 								for (const auto& [path, selected] : selection) {
 									if (selected) {
@@ -542,7 +564,7 @@ int main(int, char**)
 								// No project with this name, create a new one
 								Project new_project;
 								new_project.name = project_name_buffer;
-								new_project.root_path = path_buffer;
+								new_project.root_paths = workspace_roots();
 								for (const auto& [path, selected] : selection) {
 									if (selected) {
 										new_project.selected_paths.push_back(path);
@@ -552,29 +574,410 @@ int main(int, char**)
 								current_project_idx = static_cast<int>(projects.size() - 1);
 							}
 						}
-						SaveProjects();
+						SaveProjects(projects);
 					}
 				}
+                ImGui::EndDisabled();
                 ImGui::Separator();
             }
 
-            ImGui::InputText("Path", path_buffer, sizeof(path_buffer));
+            if (ImGui::InputText("Path", path_buffer, sizeof(path_buffer)))
+            {
+                scan.Start(path_buffer);
+            }
             ImGui::SameLine();
             if (ImGui::Button("Recalculate States"))
             {
                 directory_state_cache.clear();
+                scan.Start(path_buffer);
+                start_extra_scans();
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Expand All")) {
+                SetDirectoryTreeOpen(true);
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Collapse All")) {
+                SetDirectoryTreeOpen(false);
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Token Heatmap")) {
+                show_heatmap = !show_heatmap;
+            }
+            if (!extra_scans.empty() && ImGui::IsItemHovered()) {
+                ImGui::SetTooltip("Maps %s only, not the additional roots", path_buffer);
+            }
+            {
+                // Link cycles are cut under every policy; this only decides what links show up as.
+                static const char* link_policy_names[] = {"Follow", "Skip", "Follow, list each folder once"};
+                int policy = static_cast<int>(link_policy);
+                if (ImGui::Combo("Symlinks", &policy, link_policy_names, IM_ARRAYSIZE(link_policy_names)))
+                {
+                    link_policy = static_cast<LinkPolicy>(policy);
+                    scan.SetLinkPolicy(link_policy);
+                    directory_state_cache.clear();
+                    scan.Start(path_buffer);
+                    start_extra_scans();
+                }
+            }
+
+            if (ImGui::CollapsingHeader("Additional Roots"))
+            {
+                int remove_index = -1;
+                for (int i = 0; i < static_cast<int>(extra_roots.size()); ++i)
+                {
+                    ImGui::PushID(i);
+                    if (ImGui::SmallButton("Remove")) {
+                        remove_index = i;
+                    }
+                    ImGui::SameLine();
+                    ImGui::TextUnformatted(extra_roots[i].c_str());
+                    ImGui::PopID();
+                }
+                static char add_root_buffer[1024] = "";
+                bool add_root = ImGui::InputTextWithHint("##AddRoot", "Another root folder", add_root_buffer, sizeof(add_root_buffer), ImGuiInputTextFlags_EnterReturnsTrue);
+                ImGui::SameLine();
+                add_root |= ImGui::Button("Add Root");
+                if (add_root && add_root_buffer[0] != '\0')
+                {
+                    extra_roots.push_back(add_root_buffer);
+                    add_root_buffer[0] = '\0';
+                    start_extra_scans();
+                }
+                if (remove_index >= 0)
+                {
+                    extra_roots.erase(extra_roots.begin() + remove_index);
+                    start_extra_scans();
+                }
+            }
+
+            if (ImGui::IsKeyChordPressed(ImGuiMod_Ctrl | ImGuiKey_P)) {
+                ImGui::SetKeyboardFocusHere();
+            }
+            if (ImGui::InputTextWithHint("Find", "Fuzzy file search (Ctrl+P)", find_buffer, sizeof(find_buffer))) {
+                find_dirty = true;
+            }
+            const bool fuzzy_index_current = !fuzzy_indexes.empty() && fuzzy_indexes_current(workspace_trees());
+            if (find_dirty && fuzzy_index_current)
+            {
+                const auto find_begin = std::chrono::steady_clock::now();
+                find_results.clear();
+                find_match_count = 0;
+                for (const auto& index : fuzzy_indexes)
+                {
+                    find_results.push_back(FuzzyFind(*index, find_buffer, 200));
+                    find_match_count += find_results.back().size();
+                }
+                find_ms = MillisecondsSince(find_begin);
+                find_dirty = false;
+            }
+            const bool show_find_results = find_buffer[0] != '\0' && fuzzy_index_current;
+            if (show_find_results)
+            {
+                ImGui::TextDisabled("%zu matches in %.1f ms", find_match_count, find_ms);
+                ImGui::SameLine();
+                if (ImGui::SmallButton("Select All Matches"))
+                {
+                    for (size_t i = 0; i < find_results.size(); ++i)
+                    {
+                        for (const auto& match : find_results[i])
+                        {
+                            fs::path entry_path = fuzzy_indexes[i]->tree->Path(match.node);
+                            selection[entry_path.string()] = true;
+                            InvalidateParentCaches(entry_path);
+                        }
+                    }
+                }
+            }
+
+            if (ImGui::CollapsingHeader("Content Search"))
+            {
+                bool start_search = ImGui::InputTextWithHint("##ContentSearch", "Text in files", search_buffer, sizeof(search_buffer), ImGuiInputTextFlags_EnterReturnsTrue);
+                ImGui::SameLine();
+                start_search |= ImGui::Button("Search");
+                ImGui::Checkbox("Regex", &search_regex);
+                ImGui::SameLine();
+                ImGui::Checkbox("Ignore case", &search_ignore_case);
+
+                std::vector<std::shared_ptr<const FileTree>> trees = workspace_trees();
+                if (start_search && !trees.empty() && search_buffer[0] != '\0')
+                {
+                    // Abandon a search that is still running; its result would be stale anyway.
+                    content_search_cancel->store(true);
+                    if (content_search.valid()) {
+                        content_search.wait();
+                    }
+                    content_search_cancel = std::make_shared<std::atomic<bool>>(false);
+                    search_trees = std::move(trees);
+                    search_results.clear();
+                    search_begin = std::chrono::steady_clock::now();
+
+                    ContentSearchOptions options;
+                    options.pattern = search_buffer;
+                    options.use_regex = search_regex;
+                    options.ignore_case = search_ignore_case;
+                    content_search = std::async(std::launch::async, [trees = search_trees, options, cancel = content_search_cancel]() {
+                        std::vector<ContentSearchResult> results;
+                        for (const auto& tree : trees)
+                        {
+                            results.push_back(SearchContents(*tree, options, cancel.get()));
+                            if (!results.back().error.empty()) {
+                                break; // A bad pattern is bad for every root
+                            }
+                        }
+                        WakeMainLoop();
+                        return results;
+                    });
+                }
+
+                if (content_search.valid())
+                {
+                    ImGui::TextDisabled("Searching...");
+                }
+                else if (!search_results.empty() && !search_results.back().error.empty())
+                {
+                    ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "%s", search_results.back().error.c_str());
+                }
+                else if (!search_results.empty())
+                {
+                    ContentSearchResult total;
+                    for (const auto& result : search_results)
+                    {
+                        total.files_searched += result.files_searched;
+                        total.bytes_searched += result.bytes_searched;
+                        total.nodes.insert(total.nodes.end(), result.nodes.begin(), result.nodes.end());
+                    }
+                    ImGui::TextDisabled("%zu of %zu files match (%.1f MB in %.0f ms)", total.nodes.size(), total.files_searched,
+                                        total.bytes_searched / (1024.0 * 1024.0), search_ms);
+                    if (!total.nodes.empty() && ImGui::Button("Add Matches to Selection"))
+                    {
+                        for (size_t i = 0; i < search_results.size(); ++i)
+                        {
+                            for (uint32_t node : search_results[i].nodes)
+                            {
+                                fs::path entry_path = search_trees[i]->Path(node);
+                                selection[entry_path.string()] = true;
+                                InvalidateParentCaches(entry_path);
+                            }
+                        }
+                    }
+                }
+            }
+
+            if (ImGui::CollapsingHeader("Git Changes"))
+            {
+                ImGui::Checkbox("Unstaged", &git_worktree);
+                ImGui::SameLine();
+                ImGui::Checkbox("Staged", &git_staged);
+                ImGui::InputTextWithHint("##GitSince", "Changed since (branch, tag, commit)", git_since_buffer, sizeof(git_since_buffer));
+                ImGui::SameLine();
+                std::vector<std::shared_ptr<const FileTree>> trees = workspace_trees();
+                if (ImGui::Button("Find Changes") && !trees.empty() && !git_lookup.valid())
+                {
+                    git_trees = std::move(trees);
+                    git_results.clear();
+                    git_begin = std::chrono::steady_clock::now();
+
+                    GitChangesOptions options;
+                    options.worktree = git_worktree;
+                    options.staged = git_staged;
+                    options.since = git_since_buffer;
+                    git_lookup = std::async(std::launch::async, [trees = git_trees, options]() {
+                        std::vector<GitChangesResult> results;
+                        for (const auto& tree : trees) {
+                            results.push_back(FindGitChanges(*tree, options));
+                        }
+                        WakeMainLoop();
+                        return results;
+                    });
+                }
+
+                if (git_lookup.valid())
+                {
+                    ImGui::TextDisabled("Reading git index...");
+                }
+                else if (!git_results.empty())
+                {
+                    // A root outside any repository reports its error; the others still list their changes.
+                    GitChangesResult total;
+                    for (size_t i = 0; i < git_results.size(); ++i)
+                    {
+                        const GitChangesResult& result = git_results[i];
+                        if (!result.error.empty())
+                        {
+                            if (git_results.size() > 1) {
+                                ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "%s: %s", git_trees[i]->root_path.c_str(), result.error.c_str());
+                            } else {
+                                ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "%s", result.error.c_str());
+                            }
+                            continue;
+                        }
+                        total.nodes.insert(total.nodes.end(), result.nodes.begin(), result.nodes.end());
+                        total.changed_paths += result.changed_paths;
+                        total.index_entries += result.index_entries;
+                        total.files_hashed += result.files_hashed;
+                    }
+                    const bool any_looked_up = std::any_of(git_results.begin(), git_results.end(), [](const auto& result) { return result.error.empty(); });
+                    if (any_looked_up)
+                    {
+                        ImGui::TextDisabled("%zu changed files (%zu of %zu tracked files hashed, %.0f ms)", total.nodes.size(), total.files_hashed,
+                                            total.index_entries, git_ms);
+                        if (total.changed_paths > total.nodes.size()) {
+                            ImGui::TextDisabled("%zu more deleted or not in the tree", total.changed_paths - total.nodes.size());
+                        }
+                    }
+                    if (!total.nodes.empty() && ImGui::Button("Add Changes to Selection"))
+                    {
+                        for (size_t i = 0; i < git_results.size(); ++i)
+                        {
+                            for (uint32_t node : git_results[i].nodes)
+                            {
+                                fs::path entry_path = git_trees[i]->Path(node);
+                                selection[entry_path.string()] = true;
+                                InvalidateParentCaches(entry_path);
+                            }
+                        }
+                    }
+                }
             }
 
-            ImGui::BeginChild("DirectoryTree", ImVec2(0, -ImGui::GetFrameHeightWithSpacing()), true);
-            if (fs::exists(path_buffer))
+            // Leave room below the tree for the generation options and the Generate button.
+            const float footer_height = 3 * ImGui::GetFrameHeightWithSpacing();
+            ImGui::BeginChild("DirectoryTree", ImVec2(0, -footer_height), true);
+            // Keep showing the previous tree of the same root while a rescan is running.
+            std::shared_ptr<const FileTree> tree = scan.Tree();
             {
-                DrawDirectoryTree(path_buffer, selection);
+                ScopedMetricTimer tree_draw_timer(Metric::TreeDrawNanoseconds);
+                if (show_find_results)
+                {
+                    for (size_t i = 0; i < find_results.size(); ++i)
+                    {
+                        ImGui::PushID(static_cast<int>(i)); // Node indices repeat across roots
+                        DrawFindResults(*fuzzy_indexes[i]->tree, find_results[i], selection);
+                        ImGui::PopID();
+                    }
+                }
+                else
+                {
+                    // A single root is drawn flat; with several, each gets a node of its own.
+                    const bool multi_root = !extra_scans.empty();
+                    if (!multi_root || ImGui::TreeNodeEx(path_buffer, ImGuiTreeNodeFlags_DefaultOpen))
+                    {
+                        if (tree && tree->root_path == path_buffer)
+                        {
+                            if (scan.IsRunning()) {
+                                ImGui::TextDisabled("Refreshing...");
+                            }
+                            // Totals lag a rescan briefly; until they catch up the tree is drawn without them.
+                            const std::shared_ptr<const TreeTotals> totals = token_heatmap.Totals();
+                            DrawDirectoryTree(*tree, 0, tree->root_path, selection, totals && totals->tree == tree ? totals.get() : nullptr);
+                        }
+                        else if (scan.IsRunning())
+                        {
+                            ImGui::TextDisabled("Scanning %s...", scan.PendingRoot().c_str());
+                        }
+                        if (multi_root) {
+                            ImGui::TreePop();
+                        }
+                    }
+                    for (const auto& extra_scan : extra_scans)
+                    {
+                        const std::string& root = extra_scan->PendingRoot();
+                        if (ImGui::TreeNodeEx(root.c_str(), ImGuiTreeNodeFlags_DefaultOpen))
+                        {
+                            if (std::shared_ptr<const FileTree> extra_tree = extra_scan->Tree()) {
+                                DrawDirectoryTree(*extra_tree, 0, extra_tree->root_path, selection);
+                            } else {
+                                ImGui::TextDisabled("Scanning %s...", root.c_str());
+                            }
+                            ImGui::TreePop();
+                        }
+                    }
+                }
             }
             ImGui::EndChild();
 
+            ImGui::Checkbox("Deduplicate identical files", &context_options.deduplicate);
+            {
+                static const char* transform_names[] = {"Verbatim", "Strip comments & blank lines", "Outline (signatures only)"};
+                int transform = static_cast<int>(context_options.transform);
+                if (ImGui::Combo("Transform", &transform, transform_names, IM_ARRAYSIZE(transform_names))) {
+                    context_options.transform = static_cast<TransformMode>(transform);
+                }
+                static const char* format_names[] = {"Plain", "Markdown", "XML", "JSON lines"};
+                int format = static_cast<int>(context_options.format);
+                if (ImGui::Combo("Format", &format, format_names, IM_ARRAYSIZE(format_names))) {
+                    context_options.format = static_cast<OutputFormat>(format);
+                }
+                static const char* delta_names[] = {"Everything", "Changed files", "Unified diffs"};
+                int delta = static_cast<int>(context_options.delta);
+                if (ImGui::Combo("Since snapshot", &delta, delta_names, IM_ARRAYSIZE(delta_names))) {
+                    context_options.delta = static_cast<DeltaMode>(delta);
+                }
+                ImGui::InputTextWithHint("Contents from", "Work tree, or a branch, tag or commit", revision_buffer, sizeof(revision_buffer));
+                if (!source_status.empty()) {
+                    ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "%s", source_status.c_str());
+                }
+            }
             if (ImGui::Button("Generate Context", ImVec2(-1, 0)))
             {
-                GenerateContext(selection, aggregated_text, file_count, token_count);
+                ContextSnapshot since;
+                GitCommitSource source;
+                ContextOptions options = options_with_snapshot(since);
+                if (open_source(source, options)) {
+                    GenerateContext(selection, options, aggregated_text, context_stats, &generated_snapshot);
+                }
+            }
+            {
+                ImGui::InputText("##SnapshotPath", snapshot_buffer, sizeof(snapshot_buffer));
+                ImGui::SameLine();
+                if (ImGui::Button("Save snapshot"))
+                {
+                    snapshot_status = SaveContextSnapshot(generated_snapshot, snapshot_buffer)
+                        ? "Snapshot of " + std::to_string(generated_snapshot.files.size()) + " files saved"
+                        : "Could not save the snapshot, see the console";
+                }
+                if (!snapshot_status.empty()) {
+                    ImGui::TextDisabled("%s", snapshot_status.c_str());
+                }
+            }
+            {
+                // Huge bundles are streamed from the selection into a multi-threaded zstd
+                // compressor, batch by batch, instead of being generated into the viewer first.
+                static char export_buffer[1024] = "context.txt.zst";
+                ImGui::InputText("##ExportPath", export_buffer, sizeof(export_buffer));
+                if (ImGui::Button("Export .zst") && !context_export.valid())
+                {
+                    auto since = std::make_unique<ContextSnapshot>();
+                    auto source = std::make_unique<GitCommitSource>();
+                    ContextOptions options = options_with_snapshot(*since);
+                    if (!open_source(*source, options)) {
+                        export_status = "Export failed: " + source_status;
+                    } else {
+                        export_status = "Exporting...";
+                        context_export = std::async(std::launch::async, [selection = selection, options, since = std::move(since),
+                                                                         source = std::move(source), path = std::string(export_buffer)]() mutable {
+                            // The options point at the snapshot and source this job now owns.
+                            if (options.since) {
+                                options.since = since.get();
+                            }
+                            if (options.source) {
+                                options.source = source.get();
+                            }
+                            ExportResult result;
+                            result.exported = ExportCompressedContext(selection, options, path, result.stats, result.export_stats);
+                            WakeMainLoop();
+                            return result;
+                        });
+                    }
+                }
+                ImGui::SameLine();
+                if (ImGui::Button("Open .zst")) {
+                    open_compressed_context(export_buffer);
+                }
+                if (!export_status.empty()) {
+                    ImGui::TextDisabled("%s", export_status.c_str());
+                }
             }
             ImGui::EndChild();
 
@@ -587,28 +990,85 @@ int main(int, char**)
                 ImGui::SetClipboardText(aggregated_text.c_str());
             }
             ImGui::SameLine();
-            ImGui::Text("Files: %d | Tokens: %d", file_count, token_count);
+            ImGui::Text("Files: %d | Tokens: %d", context_stats.file_count, context_stats.token_count);
+            if (context_stats.duplicate_count > 0) {
+                ImGui::SameLine();
+                ImGui::TextDisabled("(%d duplicates collapsed)", context_stats.duplicate_count);
+            }
+            if (context_stats.added_count + context_stats.modified_count + context_stats.removed_count + context_stats.unchanged_count > 0)
+            {
+                ImGui::SameLine();
+                ImGui::TextDisabled("(%d added, %d modified, %d removed, %d unchanged)", context_stats.added_count,
+                                    context_stats.modified_count, context_stats.removed_count, context_stats.unchanged_count);
+            }
+            if (context_stats.tokens_saved > 0)
+            {
+                ImGui::SameLine();
+                ImGui::TextDisabled("(%d tokens saved)", context_stats.tokens_saved);
+                if (ImGui::IsItemHovered() && ImGui::BeginTooltip())
+                {
+                    // Biggest savings first; the full list can be thousands of files long.
+                    const size_t shown = std::min<size_t>(context_stats.savings.size(), 20);
+                    for (size_t i = 0; i < shown; ++i)
+                    {
+                        const auto& saving = context_stats.savings[i];
+                        ImGui::Text("%6d -> %6d  %s", saving.original_tokens, saving.final_tokens, saving.path.c_str());
+                    }
+                    if (context_stats.savings.size() > shown) {
+                        ImGui::TextDisabled("...and %zu more files", context_stats.savings.size() - shown);
+                    }
+                    ImGui::EndTooltip();
+                }
+            }
 
-            ImGui::InputTextMultiline("##source", &aggregated_text[0], aggregated_text.size(), ImVec2(-1, -1), ImGuiInputTextFlags_ReadOnly);
+            DrawContextViewer(aggregated_text);
             ImGui::EndChild();
 
             ImGui::End();
         }
 
+        if (ImGui::IsKeyPressed(ImGuiKey_F12, false)) {
+            show_perf_overlay = !show_perf_overlay;
+        }
+        if (show_perf_overlay) {
+            perf_overlay.Draw(&show_perf_overlay);
+        }
+        if (show_heatmap) {
+            heatmap_window.Draw(token_heatmap, selection, &show_heatmap);
+        }
+
 
         // Rendering
-        ImGui::Render();
-        glViewport(0, 0, (int)io.DisplaySize.x, (int)io.DisplaySize.y);
-        glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, clear_color.w);
-        glClear(GL_COLOR_BUFFER_BIT);
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        {
+            ZoneNamedN(render_zone, "Render", true);
+            ImGui::Render();
+            glViewport(0, 0, (int)io.DisplaySize.x, (int)io.DisplaySize.y);
+            glClearColor(clear_color.x * clear_color.w, clear_color.y * clear_color.w, clear_color.z * clear_color.w, clear_color.w);
+            glClear(GL_COLOR_BUFFER_BIT);
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
 
         // Tracy frame marker
         FrameMark;
+        GetFrameArena().Reset();
         SDL_GL_SwapWindow(window);
+
+        if (!first_frame_presented)
+        {
+            first_frame_presented = true;
+            double ms = MillisecondsSince(startup_begin);
+            ReportStartupMilestone("Time to first frame", ms);
+            if (ms > kFirstFrameBudgetMs)
+            {
+                char message[128];
+                snprintf(message, sizeof(message), "Warning: first frame exceeded the %.0f ms budget", kFirstFrameBudgetMs);
+                ReportStartup(message);
+            }
+        }
     }
 
     // --- Cleanup ---
+    context_server.Stop();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplSDL2_Shutdown();
     ImGui::DestroyContext();
@@ -0,0 +1,163 @@
+#include "mapped_file.h"
+
+#include <utility>
+
+#include "metrics.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+bool ReadFileIdentity(const std::string& path, FileIdentity& identity)
+{
+    AddMetric(Metric::FilesystemCalls);
+#ifdef _WIN32
+    // Directories can only be opened with backup semantics; no access rights are needed for the index.
+    HANDLE file = CreateFileA(path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    BY_HANDLE_FILE_INFORMATION info;
+    const bool ok = GetFileInformationByHandle(file, &info) != 0;
+    CloseHandle(file);
+    AddMetric(Metric::FilesystemCalls, 2);
+    if (!ok) {
+        return false;
+    }
+    identity.device = info.dwVolumeSerialNumber;
+    identity.inode = (static_cast<uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    identity.device = static_cast<uint64_t>(st.st_dev);
+    identity.inode = static_cast<uint64_t>(st.st_ino);
+#endif
+    return true;
+}
+
+MappedFile::MappedFile(const std::string& path)
+{
+    AddMetric(Metric::FilesystemCalls); // The open, whether or not it succeeds
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    BY_HANDLE_FILE_INFORMATION info;
+    if (!GetFileInformationByHandle(file, &info)) {
+        CloseHandle(file);
+        return;
+    }
+    identity.device = info.dwVolumeSerialNumber;
+    identity.inode = (static_cast<uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+    LARGE_INTEGER file_size;
+    file_size.LowPart = info.nFileSizeLow;
+    file_size.HighPart = static_cast<LONG>(info.nFileSizeHigh);
+    if (file_size.QuadPart == 0) {
+        regular_file = true; // CreateFileA cannot open directories without FILE_FLAG_BACKUP_SEMANTICS
+        CloseHandle(file);
+        return;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return;
+    }
+    file_handle = file;
+    mapping_handle = mapping;
+    data = static_cast<const char*>(view);
+    size = static_cast<size_t>(file_size.QuadPart);
+    regular_file = true;
+    AddMetric(Metric::FilesystemCalls, 3); // Size, mapping, view
+#else
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return;
+    }
+    identity.device = static_cast<uint64_t>(st.st_dev);
+    identity.inode = static_cast<uint64_t>(st.st_ino);
+    if (st.st_size == 0) {
+        regular_file = true;
+        close(fd);
+        return;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps its own reference to the file.
+    if (view == MAP_FAILED) {
+        return;
+    }
+    data = static_cast<const char*>(view);
+    size = static_cast<size_t>(st.st_size);
+    regular_file = true;
+    AddMetric(Metric::FilesystemCalls, 3); // fstat, mmap, close
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        std::swap(data, other.data);
+        std::swap(size, other.size);
+        std::swap(regular_file, other.regular_file);
+        std::swap(identity, other.identity);
+#ifdef _WIN32
+        std::swap(file_handle, other.file_handle);
+        std::swap(mapping_handle, other.mapping_handle);
+#endif
+    }
+    return *this;
+}
+
+void MappedFile::Close()
+{
+    if (!data) {
+        return;
+    }
+    AddMetric(Metric::FilesystemCalls);
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(mapping_handle);
+    CloseHandle(file_handle);
+    mapping_handle = nullptr;
+    file_handle = nullptr;
+#else
+    munmap(const_cast<char*>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// The file itself rather than a path to it: paths with the same identity (hard
+// links, symlinks, overlapping roots) always have the same content.
+struct FileIdentity
+{
+    uint64_t device = 0;
+    uint64_t inode = 0;
+
+    bool operator==(const FileIdentity& other) const { return device == other.device && inode == other.inode; }
+};
+
+struct FileIdentityHash
+{
+    size_t operator()(const FileIdentity& identity) const
+    {
+        return static_cast<size_t>(identity.inode * 0x9E3779B97F4A7C15ull ^ identity.device);
+    }
+};
+
+// Identity of whatever `path` names, following symlinks; works for directories too.
+bool ReadFileIdentity(const std::string& path, FileIdentity& identity);
+
+// A read-only memory mapping of a whole file. Empty and unreadable files simply
+// leave the mapping invalid; callers fall back to ordinary reads if they care.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool IsValid() const { return data != nullptr; }
+    // The path named a regular file that is now mapped, or an empty one. False for
+    // directories and unreadable files, so callers need no stat of their own.
+    bool IsRegularFile() const { return regular_file; }
+    // Only meaningful when IsRegularFile().
+    const FileIdentity& Identity() const { return identity; }
+    const char* Data() const { return data; }
+    size_t Size() const { return size; }
+    std::string_view View() const { return std::string_view(data, size); }
+
+private:
+    void Close();
+
+    const char* data = nullptr;
+    size_t size = 0;
+    bool regular_file = false;
+    FileIdentity identity;
+#ifdef _WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#endif
+};
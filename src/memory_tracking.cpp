@@ -0,0 +1,54 @@
+// Replaces the global operator new/delete to count heap allocations per thread, so
+// the performance overlay and the frame benchmark can show allocations per frame.
+// With ENABLE_TRACY_MEMORY every allocation is also reported to Tracy's memory view.
+// The "secure" variants are safe to call before Tracy starts and after it shuts
+// down, which static objects require.
+#include <cstdlib>
+#include <new>
+
+#include "metrics.h"
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+
+void* operator new(std::size_t size)
+{
+    void* pointer = std::malloc(size == 0 ? 1 : size);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    thread_heap_allocations++;
+#ifdef ENABLE_TRACY_MEMORY
+    TracySecureAlloc(pointer, size);
+#endif
+    return pointer;
+}
+
+void* operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+#ifdef ENABLE_TRACY_MEMORY
+    TracySecureFree(pointer);
+#endif
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    ::operator delete(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    ::operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    ::operator delete(pointer);
+}
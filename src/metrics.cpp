@@ -0,0 +1,39 @@
+#include "metrics.h"
+
+MetricSlot metric_slots[kMetricCount];
+thread_local uint64_t thread_heap_allocations = 0;
+
+const char* MetricName(Metric metric)
+{
+    switch (metric)
+    {
+    case Metric::TreeDrawNanoseconds: return "Tree draw time";
+    case Metric::DirectoryStateCacheHits: return "State cache hits";
+    case Metric::DirectoryStateCacheMisses: return "State cache misses";
+    case Metric::FilesystemCalls: return "Filesystem calls";
+    case Metric::ScanNanoseconds: return "Scan time";
+    case Metric::GenerateNanoseconds: return "Generate time";
+    case Metric::GenerateBytesRead: return "Generate bytes read";
+    case Metric::GenerateFiles: return "Generate files";
+    case Metric::Count: break;
+    }
+    return "?";
+}
+
+MetricsSnapshot MetricsSnapshot::operator-(const MetricsSnapshot& earlier) const
+{
+    MetricsSnapshot delta;
+    for (size_t i = 0; i < kMetricCount; ++i) {
+        delta.values[i] = values[i] - earlier.values[i];
+    }
+    return delta;
+}
+
+MetricsSnapshot SnapshotMetrics()
+{
+    MetricsSnapshot snapshot;
+    for (size_t i = 0; i < kMetricCount; ++i) {
+        snapshot.values[i] = metric_slots[i].value.load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
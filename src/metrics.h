@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Process-wide counters behind the in-app performance overlay. Any thread may bump
+// them: each is a relaxed atomic on its own cache line, so there are no locks and
+// parallel workers do not fight over a shared line. Readers take a snapshot and
+// diff it against the previous one to get per-frame or per-operation figures.
+enum class Metric
+{
+    TreeDrawNanoseconds,
+    DirectoryStateCacheHits,
+    DirectoryStateCacheMisses,
+    FilesystemCalls,        // stat/open/mmap/readdir calls issued by our code, a close proxy for syscalls
+    ScanNanoseconds,
+    GenerateNanoseconds,
+    GenerateBytesRead,
+    GenerateFiles,
+    Count
+};
+
+constexpr size_t kMetricCount = static_cast<size_t>(Metric::Count);
+
+struct alignas(64) MetricSlot
+{
+    std::atomic<uint64_t> value{0};
+};
+
+extern MetricSlot metric_slots[kMetricCount];
+
+inline void AddMetric(Metric metric, uint64_t amount = 1)
+{
+    metric_slots[static_cast<size_t>(metric)].value.fetch_add(amount, std::memory_order_relaxed);
+}
+
+const char* MetricName(Metric metric);
+
+// Heap allocations made by the calling thread. Counted by the operator new in
+// memory_tracking.cpp; stays at zero in binaries that do not link it.
+extern thread_local uint64_t thread_heap_allocations;
+
+struct MetricsSnapshot
+{
+    uint64_t values[kMetricCount] = {};
+
+    uint64_t operator[](Metric metric) const { return values[static_cast<size_t>(metric)]; }
+    MetricsSnapshot operator-(const MetricsSnapshot& earlier) const;
+};
+
+MetricsSnapshot SnapshotMetrics();
+
+// Adds the time between construction and destruction to a *Nanoseconds metric.
+class ScopedMetricTimer
+{
+public:
+    explicit ScopedMetricTimer(Metric metric) : metric(metric), start(std::chrono::steady_clock::now()) {}
+    ~ScopedMetricTimer()
+    {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        AddMetric(metric, static_cast<uint64_t>(elapsed.count()));
+    }
+
+    ScopedMetricTimer(const ScopedMetricTimer&) = delete;
+    ScopedMetricTimer& operator=(const ScopedMetricTimer&) = delete;
+
+private:
+    Metric metric;
+    std::chrono::steady_clock::time_point start;
+};
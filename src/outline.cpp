@@ -0,0 +1,319 @@
+#include "outline.h"
+
+#include <cctype>
+#include <vector>
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+
+namespace {
+
+bool IsIdentifierChar(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+}
+
+// Returns the index just past the string/char/template literal starting at i.
+// Comments are already gone, so literals are the only thing braces can hide in.
+size_t SkipLiteral(std::string_view in, size_t i, bool script)
+{
+    const char quote = in[i];
+    if (!script && quote == '"' && i > 0 && in[i - 1] == 'R')
+    {
+        size_t open = in.find('(', i + 1);
+        if (open != std::string_view::npos && open - i <= 17)
+        {
+            std::string closing = ")" + std::string(in.substr(i + 1, open - i - 1)) + "\"";
+            size_t end = in.find(closing, open + 1);
+            return end == std::string_view::npos ? in.size() : end + closing.size();
+        }
+    }
+    for (++i; i < in.size(); ++i)
+    {
+        if (in[i] == '\\') {
+            ++i;
+        } else if (in[i] == quote) {
+            return i + 1;
+        } else if (in[i] == '\n' && quote != '`') {
+            return i; // Unterminated literal
+        }
+    }
+    return in.size();
+}
+
+bool StartsLiteral(std::string_view in, size_t i, bool script)
+{
+    const char c = in[i];
+    if (c == '"' || (script && c == '`')) {
+        return true;
+    }
+    return c == '\'' && !IsDigitSeparator(in, i);
+}
+
+// Index of the '}' matching the '{' at `open`, or in.size() if unbalanced.
+size_t MatchingBrace(std::string_view in, size_t open, bool script)
+{
+    int depth = 0;
+    size_t i = open;
+    while (i < in.size())
+    {
+        if (StartsLiteral(in, i, script)) {
+            i = SkipLiteral(in, i, script);
+            continue;
+        }
+        if (in[i] == '{') {
+            depth++;
+        } else if (in[i] == '}' && --depth == 0) {
+            return i;
+        }
+        i++;
+    }
+    return in.size();
+}
+
+// Decides whether the statement text in front of a '{' opens a scope whose
+// contents are declarations (class, namespace, ...) rather than code.
+bool IsContainerHeader(std::string_view header, bool script)
+{
+    static const char* const keywords[] = {
+        "class", "struct", "union", "namespace", "enum", "interface", "extern",
+    };
+    static const char* const script_keywords[] = {
+        "module", "declare", "import", "export", "type",
+    };
+    auto is_keyword = [&](std::string_view word) {
+        for (const char* candidate : keywords) {
+            if (word == candidate) return true;
+        }
+        if (script) {
+            for (const char* candidate : script_keywords) {
+                if (word == candidate) return true;
+            }
+        }
+        return false;
+    };
+
+    // Take the last container keyword outside any parentheses, so neither
+    // `void f(struct stat* st)` nor `void set(int type)` looks like a type, and
+    // `template <class T> void f(T)` is judged by what follows `class T`.
+    size_t keyword_end = std::string_view::npos;
+    std::string_view keyword;
+    int depth = 0;
+    size_t i = 0;
+    while (i < header.size())
+    {
+        if (!IsIdentifierChar(header[i]))
+        {
+            if (header[i] == '(') {
+                depth++;
+            } else if (header[i] == ')' && depth > 0) {
+                depth--;
+            }
+            i++;
+            continue;
+        }
+        size_t start = i;
+        while (i < header.size() && IsIdentifierChar(header[i])) {
+            i++;
+        }
+        std::string_view word = header.substr(start, i - start);
+        if (depth == 0 && is_keyword(word)) {
+            keyword = word;
+            keyword_end = i;
+        }
+    }
+    if (keyword_end == std::string_view::npos) {
+        return false;
+    }
+    // A parameter list after it makes the whole header a function.
+    std::string_view rest = header.substr(keyword_end);
+    if (rest.find('(') != std::string_view::npos) {
+        return false;
+    }
+    // `int a[] = {...}` and `struct P p = {...}` are initialisers, but a TS `type X = {...}` is a declaration.
+    return keyword == "type" || keyword == "export" || rest.find('=') == std::string_view::npos;
+}
+
+std::string OutlineBraces(std::string_view in, bool script)
+{
+    std::string out;
+    out.reserve(in.size() / 4);
+    size_t statement_start = 0;
+    size_t i = 0;
+    while (i < in.size())
+    {
+        const char c = in[i];
+        if (StartsLiteral(in, i, script))
+        {
+            size_t end = SkipLiteral(in, i, script);
+            out.append(in.data() + i, end - i);
+            i = end;
+            continue;
+        }
+
+        if (c == '{')
+        {
+            if (IsContainerHeader(in.substr(statement_start, i - statement_start), script))
+            {
+                out += '{';
+                i++;
+            }
+            else
+            {
+                out += "{ ... }";
+                i = MatchingBrace(in, i, script) + 1;
+            }
+            statement_start = i;
+            continue;
+        }
+
+        out += c;
+        if (c == ';' || c == '}') {
+            statement_start = i + 1;
+        }
+        i++;
+    }
+    return out;
+}
+
+
+size_t IndentOf(std::string_view line)
+{
+    size_t indent = 0;
+    while (indent < line.size() && (line[indent] == ' ' || line[indent] == '\t')) {
+        indent++;
+    }
+    return indent;
+}
+
+bool StartsWithWord(std::string_view text, std::string_view word)
+{
+    return text.substr(0, word.size()) == word && (text.size() == word.size() || !IsIdentifierChar(text[word.size()]));
+}
+
+// Counts triple quotes, so we know whether a line leaves us inside a docstring.
+int CountTripleQuotes(std::string_view line)
+{
+    int count = 0;
+    for (size_t i = 0; i + 3 <= line.size(); ++i)
+    {
+        if ((line[i] == '"' || line[i] == '\'') && line[i + 1] == line[i] && line[i + 2] == line[i]) {
+            count++;
+            i += 2;
+        }
+    }
+    return count;
+}
+
+int ParenBalance(std::string_view line)
+{
+    int balance = 0;
+    for (char c : line)
+    {
+        if (c == '(' || c == '[' || c == '{') balance++;
+        else if (c == ')' || c == ']' || c == '}') balance--;
+    }
+    return balance;
+}
+
+std::string OutlinePython(std::string_view in)
+{
+    std::vector<std::string_view> lines;
+    for (size_t start = 0; start < in.size(); )
+    {
+        size_t end = in.find('\n', start);
+        if (end == std::string_view::npos) end = in.size();
+        lines.push_back(in.substr(start, end - start));
+        start = end + 1;
+    }
+
+    std::string out;
+    size_t i = 0;
+    while (i < lines.size())
+    {
+        std::string_view line = lines[i];
+        out.append(line.data(), line.size());
+        out += '\n';
+        const size_t indent = IndentOf(line);
+        std::string_view stripped = line.substr(indent);
+        i++;
+
+        if (!StartsWithWord(stripped, "def") && !(StartsWithWord(stripped, "async") && stripped.find("def") != std::string_view::npos)) {
+            continue;
+        }
+
+        // The signature may continue over several lines until its brackets balance.
+        int balance = ParenBalance(stripped);
+        std::string_view last = stripped;
+        while (balance > 0 && i < lines.size())
+        {
+            last = lines[i];
+            balance += ParenBalance(last);
+            out.append(last.data(), last.size());
+            out += '\n';
+            i++;
+        }
+        size_t last_char = last.find_last_not_of(" \t\r");
+        if (last_char == std::string_view::npos || last[last_char] != ':') {
+            continue; // One-liner such as `def f(): return 1`
+        }
+
+        // Skip blank lines to find the body's indentation.
+        size_t body = i;
+        while (body < lines.size() && lines[body].find_first_not_of(" \t\r") == std::string_view::npos) {
+            body++;
+        }
+        if (body >= lines.size() || IndentOf(lines[body]) <= indent) {
+            continue;
+        }
+        const size_t body_indent = IndentOf(lines[body]);
+        i = body;
+
+        // Keep the docstring's summary line, if there is one.
+        std::string_view first = lines[i].substr(body_indent);
+        if (first.substr(0, 3) == "\"\"\"" || first.substr(0, 3) == "'''")
+        {
+            out.append(lines[i].data(), lines[i].size());
+            if (CountTripleQuotes(first) % 2 == 1) {
+                out.append(first.data(), 3); // Close the truncated docstring
+            }
+            out += '\n';
+        }
+        out.append(lines[body].data(), body_indent);
+        out += "...\n";
+
+        // Drop the rest of the body: everything indented deeper than the def, plus
+        // blank lines and the insides of multi-line strings, whatever their indent.
+        bool in_string = false;
+        while (i < lines.size())
+        {
+            std::string_view body_line = lines[i];
+            const bool blank = body_line.find_first_not_of(" \t\r") == std::string_view::npos;
+            if (!in_string && !blank && IndentOf(body_line) <= indent) {
+                break;
+            }
+            if (CountTripleQuotes(body_line) % 2 == 1) {
+                in_string = !in_string;
+            }
+            i++;
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+
+std::string ExtractOutline(std::string_view content, SourceLanguage language)
+{
+    ZoneScoped;
+    if (language == SourceLanguage::Unknown) {
+        return std::string(content);
+    }
+    std::string stripped = StripComments(content, language);
+    if (language == SourceLanguage::Python) {
+        return OutlinePython(stripped);
+    }
+    return OutlineBraces(stripped, language == SourceLanguage::Script);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "source_transform.h"
+
+// Reduces a source file to its declarations: includes/imports, type and namespace
+// bodies, fields and function signatures. Function bodies become "{ ... }" (or an
+// indented "..." in Python). Comments are stripped first; docstrings are kept.
+//
+// This is a brace/indent matcher, not a parser. It errs towards keeping text,
+// so unusual code shows up more verbose rather than disappearing.
+std::string ExtractOutline(std::string_view content, SourceLanguage language);
@@ -0,0 +1,396 @@
+#include "output_format.h"
+
+#include <algorithm>
+#include <cctype>
+
+// --- Sinks ---
+// Every formatter emits its output through one of these, so the sizing pass and
+// the writing pass run the very same code and cannot disagree.
+namespace {
+
+struct CountingSink
+{
+    size_t size = 0;
+    void Append(std::string_view text) { size += text.size(); }
+    void Append(char) { size++; }
+};
+
+struct StringSink
+{
+    std::string& out;
+    void Append(std::string_view text) { out.append(text.data(), text.size()); }
+    void Append(char c) { out.push_back(c); }
+};
+
+// Implements Measure/Write on top of a single `template <typename Sink> void Emit(file, sink)`.
+template <typename Derived>
+class SinkFormatter : public ContextFormatter
+{
+public:
+    size_t Measure(const FormattedFile& file) const override
+    {
+        CountingSink sink;
+        static_cast<const Derived*>(this)->Emit(file, sink);
+        return sink.size;
+    }
+    void Write(const FormattedFile& file, std::string& out) const override
+    {
+        StringSink sink{out};
+        static_cast<const Derived*>(this)->Emit(file, sink);
+    }
+};
+
+template <typename Sink>
+void EmitDuplicateNote(const FormattedFile& file, Sink& sink)
+{
+    sink.Append("(identical to ");
+    sink.Append(*file.duplicate_of);
+    sink.Append(')');
+}
+
+static std::string_view ChangeName(FileChange change)
+{
+    switch (change)
+    {
+    case FileChange::Added: return "added";
+    case FileChange::Modified: return "modified";
+    case FileChange::Removed: return "removed";
+    case FileChange::None: break;
+    }
+    return {};
+}
+
+// " (modified, diff)" and the like, after the path in Plain and Markdown headers.
+template <typename Sink>
+void EmitChangeNote(const FormattedFile& file, Sink& sink)
+{
+    if (file.change == FileChange::None) {
+        return;
+    }
+    sink.Append(" (");
+    sink.Append(ChangeName(file.change));
+    if (file.is_diff) {
+        sink.Append(", diff");
+    }
+    sink.Append(')');
+}
+
+// Bodies that do not end in a newline get one, so closing markup starts on its own line.
+template <typename Sink>
+void EmitBodyLine(std::string_view content, Sink& sink)
+{
+    sink.Append(content);
+    if (!content.empty() && content.back() != '\n') {
+        sink.Append('\n');
+    }
+}
+
+
+// --- Plain ---
+class PlainFormatter : public SinkFormatter<PlainFormatter>
+{
+public:
+    template <typename Sink>
+    void Emit(const FormattedFile& file, Sink& sink) const
+    {
+        sink.Append("--- ");
+        sink.Append(file.path);
+        EmitChangeNote(file, sink);
+        sink.Append(" ---\n");
+        if (file.duplicate_of) {
+            EmitDuplicateNote(file, sink);
+        } else {
+            sink.Append(file.content);
+        }
+        sink.Append('\n');
+    }
+};
+
+
+// --- Markdown ---
+// The fence is one backtick longer than the longest run inside the file, so
+// Markdown sources and embedded snippets cannot close it early.
+static size_t LongestBacktickRun(std::string_view content)
+{
+    size_t longest = 0;
+    size_t run = 0;
+    for (char c : content)
+    {
+        run = c == '`' ? run + 1 : 0;
+        longest = std::max(longest, run);
+    }
+    return longest;
+}
+
+class MarkdownFormatter : public SinkFormatter<MarkdownFormatter>
+{
+public:
+    template <typename Sink>
+    void Emit(const FormattedFile& file, Sink& sink) const
+    {
+        sink.Append("## ");
+        sink.Append(file.path);
+        EmitChangeNote(file, sink);
+        sink.Append("\n\n");
+        if (file.change == FileChange::Removed) {
+            return;
+        }
+        if (file.duplicate_of)
+        {
+            EmitDuplicateNote(file, sink);
+            sink.Append("\n\n");
+            return;
+        }
+        const size_t fence = std::max<size_t>(3, LongestBacktickRun(file.content) + 1);
+        for (size_t i = 0; i < fence; ++i) sink.Append('`');
+        sink.Append(file.is_diff ? std::string_view("diff") : FenceLanguage(file.path));
+        sink.Append('\n');
+        EmitBodyLine(file.content, sink);
+        for (size_t i = 0; i < fence; ++i) sink.Append('`');
+        sink.Append("\n\n");
+    }
+};
+
+
+// Length of the valid UTF-8 sequence starting at text[i], or 0 if it is not one.
+// Both XML and JSON writers replace invalid bytes with U+FFFD, so their output
+// stays well-formed even for binary files.
+static size_t Utf8SequenceLength(std::string_view text, size_t i)
+{
+    const unsigned char lead = static_cast<unsigned char>(text[i]);
+    size_t length;
+    unsigned int min_code_point;
+    if (lead < 0x80) return 1;
+    else if ((lead & 0xE0) == 0xC0) { length = 2; min_code_point = 0x80; }
+    else if ((lead & 0xF0) == 0xE0) { length = 3; min_code_point = 0x800; }
+    else if ((lead & 0xF8) == 0xF0) { length = 4; min_code_point = 0x10000; }
+    else return 0;
+    if (i + length > text.size()) return 0;
+
+    unsigned int code_point = lead & (0x7F >> length);
+    for (size_t k = 1; k < length; ++k)
+    {
+        const unsigned char c = static_cast<unsigned char>(text[i + k]);
+        if ((c & 0xC0) != 0x80) return 0;
+        code_point = (code_point << 6) | (c & 0x3F);
+    }
+    if (code_point < min_code_point || code_point > 0x10FFFF || (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+        return 0;
+    }
+    return length;
+}
+
+
+// --- XML ---
+// Control characters other than tab and newlines are not allowed anywhere in XML,
+// not even in CDATA, so they are replaced like invalid UTF-8.
+static constexpr std::string_view kReplacementCharacter = "\xEF\xBF\xBD";
+
+template <typename Sink>
+void EmitXmlText(std::string_view text, bool attribute, Sink& sink)
+{
+    size_t run_start = 0;
+    for (size_t i = 0; i < text.size();)
+    {
+        const unsigned char c = static_cast<unsigned char>(text[i]);
+        std::string_view replacement;
+        size_t length = 1;
+        if (c >= 0x80) {
+            length = Utf8SequenceLength(text, i);
+            if (length == 0) {
+                replacement = kReplacementCharacter;
+                length = 1;
+            }
+        } else if (c < 0x20 && c != '\t' && c != '\n' && c != '\r') {
+            replacement = kReplacementCharacter;
+        } else if (attribute) {
+            switch (c)
+            {
+            case '&': replacement = "&amp;"; break;
+            case '<': replacement = "&lt;"; break;
+            case '>': replacement = "&gt;"; break;
+            case '"': replacement = "&quot;"; break;
+            case '\n': replacement = "&#10;"; break;
+            }
+        } else if (c == ']' && text.compare(i, 3, "]]>") == 0) {
+            // "]]>" would end the section; split it across two sections instead.
+            replacement = "]]]]><![CDATA[>";
+            length = 3;
+        }
+        if (replacement.empty()) {
+            i += length;
+            continue;
+        }
+        sink.Append(text.substr(run_start, i - run_start));
+        sink.Append(replacement);
+        i += length;
+        run_start = i;
+    }
+    sink.Append(text.substr(run_start));
+}
+
+class XmlFormatter : public SinkFormatter<XmlFormatter>
+{
+public:
+    std::string_view Prologue() const override { return "<context>\n"; }
+    std::string_view Epilogue() const override { return "</context>\n"; }
+
+    template <typename Sink>
+    void Emit(const FormattedFile& file, Sink& sink) const
+    {
+        sink.Append("<file path=\"");
+        EmitXmlText(file.path, true, sink);
+        if (file.change != FileChange::None) {
+            sink.Append("\" change=\"");
+            sink.Append(ChangeName(file.change));
+        }
+        if (file.is_diff) {
+            sink.Append("\" format=\"diff");
+        }
+        if (file.change == FileChange::Removed)
+        {
+            sink.Append("\"/>\n");
+            return;
+        }
+        if (file.duplicate_of)
+        {
+            sink.Append("\" duplicate_of=\"");
+            EmitXmlText(*file.duplicate_of, true, sink);
+            sink.Append("\"/>\n");
+            return;
+        }
+        sink.Append("\"><![CDATA[\n");
+        EmitXmlText(file.content, false, sink);
+        if (!file.content.empty() && file.content.back() != '\n') {
+            sink.Append('\n');
+        }
+        sink.Append("]]></file>\n");
+    }
+};
+
+
+// --- JSON lines ---
+// Strings are escaped by hand rather than through nlohmann::json so the size can be
+// counted without building them.
+template <typename Sink>
+void EmitJsonString(std::string_view text, Sink& sink)
+{
+    static const char hex[] = "0123456789abcdef";
+    sink.Append('"');
+    size_t run_start = 0;
+    for (size_t i = 0; i < text.size();)
+    {
+        const unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\' && c < 0x80) {
+            ++i;
+            continue;
+        }
+        const size_t length = c < 0x80 ? 1 : Utf8SequenceLength(text, i);
+        if (length > 1) {
+            i += length; // Valid multi-byte sequence: copied verbatim with the run
+            continue;
+        }
+        sink.Append(text.substr(run_start, i - run_start));
+        switch (c)
+        {
+        case '"': sink.Append("\\\""); break;
+        case '\\': sink.Append("\\\\"); break;
+        case '\n': sink.Append("\\n"); break;
+        case '\r': sink.Append("\\r"); break;
+        case '\t': sink.Append("\\t"); break;
+        case '\b': sink.Append("\\b"); break;
+        case '\f': sink.Append("\\f"); break;
+        default:
+            if (c < 0x20) {
+                const char escape[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 15]};
+                sink.Append(std::string_view(escape, sizeof(escape)));
+            } else {
+                sink.Append("\\ufffd");
+            }
+            break;
+        }
+        run_start = ++i;
+    }
+    sink.Append(text.substr(run_start));
+    sink.Append('"');
+}
+
+class JsonLinesFormatter : public SinkFormatter<JsonLinesFormatter>
+{
+public:
+    template <typename Sink>
+    void Emit(const FormattedFile& file, Sink& sink) const
+    {
+        sink.Append("{\"path\":");
+        EmitJsonString(file.path, sink);
+        if (file.change != FileChange::None) {
+            sink.Append(",\"change\":\"");
+            sink.Append(ChangeName(file.change));
+            sink.Append('"');
+        }
+        if (file.change == FileChange::Removed) {
+            // Nothing but the path
+        } else if (file.duplicate_of) {
+            sink.Append(",\"duplicate_of\":");
+            EmitJsonString(*file.duplicate_of, sink);
+        } else {
+            // A diff gets its own key, so readers never mistake it for the file.
+            sink.Append(file.is_diff ? ",\"diff\":" : ",\"content\":");
+            EmitJsonString(file.content, sink);
+        }
+        sink.Append("}\n");
+    }
+};
+
+} // namespace
+
+
+std::unique_ptr<ContextFormatter> MakeFormatter(OutputFormat format)
+{
+    switch (format)
+    {
+    case OutputFormat::Markdown: return std::make_unique<MarkdownFormatter>();
+    case OutputFormat::Xml: return std::make_unique<XmlFormatter>();
+    case OutputFormat::JsonLines: return std::make_unique<JsonLinesFormatter>();
+    case OutputFormat::Plain: break;
+    }
+    return std::make_unique<PlainFormatter>();
+}
+
+std::string_view FenceLanguage(std::string_view path)
+{
+    const size_t slash = path.find_last_of("/\\");
+    const std::string_view filename = slash == std::string_view::npos ? path : path.substr(slash + 1);
+    if (filename == "CMakeLists.txt") return "cmake";
+    if (filename == "Makefile" || filename == "GNUmakefile") return "makefile";
+    if (filename == "Dockerfile") return "dockerfile";
+
+    const size_t dot = filename.find_last_of('.');
+    if (dot == std::string_view::npos) {
+        return {};
+    }
+    std::string extension(filename.substr(dot + 1));
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    static const std::pair<const char*, const char*> languages[] = {
+        {"c", "c"}, {"h", "cpp"}, {"cc", "cpp"}, {"cpp", "cpp"}, {"cxx", "cpp"}, {"c++", "cpp"}, {"hh", "cpp"},
+        {"hpp", "cpp"}, {"hxx", "cpp"}, {"h++", "cpp"}, {"inl", "cpp"}, {"ipp", "cpp"}, {"tpp", "cpp"},
+        {"m", "objectivec"}, {"mm", "objectivec"}, {"java", "java"}, {"cs", "csharp"}, {"cu", "cuda"}, {"cuh", "cuda"},
+        {"glsl", "glsl"}, {"frag", "glsl"}, {"vert", "glsl"}, {"hlsl", "hlsl"},
+        {"js", "javascript"}, {"mjs", "javascript"}, {"cjs", "javascript"}, {"jsx", "jsx"},
+        {"ts", "typescript"}, {"mts", "typescript"}, {"cts", "typescript"}, {"tsx", "tsx"},
+        {"py", "python"}, {"pyw", "python"}, {"pyi", "python"}, {"rb", "ruby"}, {"go", "go"}, {"rs", "rust"},
+        {"kt", "kotlin"}, {"kts", "kotlin"}, {"swift", "swift"}, {"php", "php"}, {"lua", "lua"},
+        {"sh", "bash"}, {"bash", "bash"}, {"zsh", "bash"}, {"ps1", "powershell"}, {"bat", "batch"}, {"cmd", "batch"},
+        {"sql", "sql"}, {"html", "html"}, {"htm", "html"}, {"css", "css"}, {"scss", "scss"}, {"xml", "xml"},
+        {"json", "json"}, {"yaml", "yaml"}, {"yml", "yaml"}, {"toml", "toml"}, {"ini", "ini"},
+        {"md", "markdown"}, {"markdown", "markdown"}, {"cmake", "cmake"},
+    };
+    for (const auto& [candidate, language] : languages)
+    {
+        if (extension == candidate) {
+            return language;
+        }
+    }
+    return {};
+}
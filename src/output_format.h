@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+enum class OutputFormat
+{
+    Plain,      // "--- path ---" headers, the original format
+    Markdown,   // A heading per file and a fenced code block tagged with its language
+    Xml,        // <file path="..."> elements with CDATA bodies inside one <context> root
+    JsonLines   // One {"path": ..., "content": ...} object per line
+};
+
+// How a file in a delta context differs from the snapshot it is taken against.
+enum class FileChange
+{
+    None,       // Not a delta context
+    Added,
+    Modified,
+    Removed     // Only the path is written
+};
+
+// One file as a formatter sees it. Duplicates have no content, only the path of
+// the first copy. In a delta context, `content` of a modified file may be a unified
+// diff against the snapshot (is_diff) instead of the whole file.
+struct FormattedFile
+{
+    std::string_view path;
+    std::string_view content;
+    const std::string* duplicate_of = nullptr;
+    FileChange change = FileChange::None;
+    bool is_diff = false;
+};
+
+// Turns files into the generated context. GenerateContext first asks for the
+// size of every entry, reserves the exact total, then writes them, so Measure()
+// must return precisely what Write() appends. The built-in formatters guarantee
+// that by running the same code against a counting sink and a string sink.
+class ContextFormatter
+{
+public:
+    virtual ~ContextFormatter() = default;
+
+    virtual size_t Measure(const FormattedFile& file) const = 0;
+    virtual void Write(const FormattedFile& file, std::string& out) const = 0;
+    // Written once before the first file and once after the last one.
+    virtual std::string_view Prologue() const { return {}; }
+    virtual std::string_view Epilogue() const { return {}; }
+};
+
+std::unique_ptr<ContextFormatter> MakeFormatter(OutputFormat format);
+
+// Markdown info string for a fence ("cpp", "python", ...), from the file name.
+// Empty when the language is not known.
+std::string_view FenceLanguage(std::string_view path);
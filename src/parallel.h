@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+inline size_t WorkerCount()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Calls fn(begin, end, worker) over [0, count) on all cores. Chunks of `grain`
+// items are handed out from a shared counter, so uneven work (big files, long
+// paths) balances itself: an idle thread simply grabs the next chunk.
+// `worker` is in [0, WorkerCount()) and lets callers keep per-thread results.
+template <typename Fn>
+void ParallelFor(size_t count, size_t grain, Fn&& fn)
+{
+    if (count == 0) {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+    const size_t workers = std::min(WorkerCount(), (count + grain - 1) / grain);
+    if (workers <= 1) {
+        fn(size_t(0), count, size_t(0));
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    auto run = [&](size_t worker) {
+        for (;;)
+        {
+            size_t begin = next.fetch_add(grain, std::memory_order_relaxed);
+            if (begin >= count) {
+                break;
+            }
+            fn(begin, std::min(count, begin + grain), worker);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (size_t worker = 1; worker < workers; ++worker) {
+        threads.emplace_back(run, worker);
+    }
+    run(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
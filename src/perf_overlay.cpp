@@ -0,0 +1,90 @@
+#include "perf_overlay.h"
+
+#include <algorithm>
+
+#include "frame_arena.h"
+#include "imgui.h"
+#include "selection.h"
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+
+void PerfOverlay::NewFrame()
+{
+    const auto now = std::chrono::steady_clock::now();
+    const MetricsSnapshot snapshot = SnapshotMetrics();
+    if (has_previous_frame)
+    {
+        frame_ms_history[history_offset] = std::chrono::duration<float, std::milli>(now - last_frame_start).count();
+        history_offset = (history_offset + 1) % kHistorySize;
+        last_frame = snapshot - previous_snapshot;
+        last_frame_allocations = thread_heap_allocations - previous_allocations;
+        if (last_frame[Metric::GenerateNanoseconds] > 0)
+        {
+            last_generate_ns = last_frame[Metric::GenerateNanoseconds];
+            last_generate_bytes = last_frame[Metric::GenerateBytesRead];
+            last_generate_files = last_frame[Metric::GenerateFiles];
+        }
+    }
+    previous_snapshot = snapshot;
+    previous_allocations = thread_heap_allocations;
+    last_frame_start = now;
+    has_previous_frame = true;
+
+    // The same figures as Tracy plots, whether or not the overlay is shown.
+    TracyPlot("State cache entries", static_cast<int64_t>(directory_state_cache.size()));
+    TracyPlot("State cache misses", static_cast<int64_t>(last_frame[Metric::DirectoryStateCacheMisses]));
+    TracyPlot("Filesystem calls", static_cast<int64_t>(last_frame[Metric::FilesystemCalls]));
+    TracyPlot("Tree draw ms", last_frame[Metric::TreeDrawNanoseconds] / 1e6);
+    TracyPlot("Heap allocations per frame", static_cast<int64_t>(last_frame_allocations));
+    if (last_frame[Metric::GenerateNanoseconds] > 0) {
+        TracyPlot("Generate MB/s", last_generate_bytes / (1024.0 * 1024.0) / (last_generate_ns / 1e9));
+    }
+}
+
+void PerfOverlay::Draw(bool* open)
+{
+    const ImGuiIO& io = ImGui::GetIO();
+    ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x - 10.0f, 10.0f), ImGuiCond_Always, ImVec2(1.0f, 0.0f));
+    ImGui::SetNextWindowBgAlpha(0.85f);
+    const ImGuiWindowFlags flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings |
+                                   ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoMove;
+    if (!ImGui::Begin("Performance", open, flags)) {
+        ImGui::End();
+        return;
+    }
+
+    // --- Frame ---
+    const int newest = (history_offset + kHistorySize - 1) % kHistorySize;
+    const float worst_ms = *std::max_element(frame_ms_history, frame_ms_history + kHistorySize);
+    ImGui::Text("Frame %.2f ms (%.0f FPS), worst %.2f ms", frame_ms_history[newest], io.Framerate, worst_ms);
+    ImGui::PlotLines("##frame_times", frame_ms_history, kHistorySize, history_offset, nullptr, 0.0f, std::max(worst_ms, 16.7f), ImVec2(260.0f, 40.0f));
+    ImGui::Text("Tree draw  %.3f ms", last_frame[Metric::TreeDrawNanoseconds] / 1e6);
+    ImGui::Text("Heap allocations %llu, frame arena %.1f KB", static_cast<unsigned long long>(last_frame_allocations),
+                GetFrameArena().LastFrameBytes() / 1024.0);
+
+    // --- Selection state cache ---
+    ImGui::Separator();
+    const uint64_t hits = last_frame[Metric::DirectoryStateCacheHits];
+    const uint64_t misses = last_frame[Metric::DirectoryStateCacheMisses];
+    ImGui::Text("State cache %zu entries", directory_state_cache.size());
+    ImGui::Text("  %llu hits, %llu misses (%.1f%% hit)", static_cast<unsigned long long>(hits), static_cast<unsigned long long>(misses),
+                hits + misses > 0 ? 100.0 * hits / (hits + misses) : 100.0);
+
+    // --- I/O ---
+    ImGui::Separator();
+    ImGui::Text("Filesystem calls  %llu this frame", static_cast<unsigned long long>(last_frame[Metric::FilesystemCalls]));
+    ImGui::Text("Total             %llu", static_cast<unsigned long long>(previous_snapshot[Metric::FilesystemCalls]));
+    if (last_generate_ns > 0)
+    {
+        const double seconds = last_generate_ns / 1e9;
+        ImGui::Text("Last generate %.1f ms: %.1f MB read", last_generate_ns / 1e6, last_generate_bytes / (1024.0 * 1024.0));
+        ImGui::Text("  %.1f MB/s, %.0f files/s", last_generate_bytes / (1024.0 * 1024.0) / seconds, last_generate_files / seconds);
+    }
+    else
+    {
+        ImGui::TextDisabled("No context generated yet");
+    }
+    ImGui::End();
+}
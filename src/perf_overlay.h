@@ -0,0 +1,34 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "metrics.h"
+
+// Small always-on-top window with frame timing and the metrics registry's counters,
+// for when Tracy is not attached. Toggled with F12 in the app. NewFrame also feeds
+// the per-frame figures to Tracy plots when Tracy is built in.
+class PerfOverlay
+{
+public:
+    // Call once per frame, right after ImGui::NewFrame. Closes the books on the previous frame.
+    void NewFrame();
+    void Draw(bool* open);
+
+private:
+    static constexpr int kHistorySize = 120;
+
+    std::chrono::steady_clock::time_point last_frame_start;
+    MetricsSnapshot previous_snapshot;
+    MetricsSnapshot last_frame;         // Counter deltas over the previous frame
+    float frame_ms_history[kHistorySize] = {};
+    int history_offset = 0;
+    bool has_previous_frame = false;
+    uint64_t previous_allocations = 0;
+    uint64_t last_frame_allocations = 0;   // UI thread heap allocations over the previous frame
+
+    // The most recent GenerateContext call; it runs inside a single frame.
+    uint64_t last_generate_ns = 0;
+    uint64_t last_generate_bytes = 0;
+    uint64_t last_generate_files = 0;
+};
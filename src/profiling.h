@@ -0,0 +1,20 @@
+#pragma once
+
+// Tracy when the build enables it (cmake -DENABLE_TRACY=ON, the default). Otherwise
+// the macros we use compile to nothing, so release builds carry no profiler client
+// and Tracy's sources are not needed at all.
+#ifdef TRACY_ENABLE
+#include "tracy/Tracy.hpp"
+#else
+#define ZoneScoped
+#define ZoneScopedN(name)
+#define ZoneNamedN(variable, name, active)
+#define ZoneValue(value)
+#define ZoneText(text, size)
+#define FrameMark
+#define TracyMessage(text, size)
+#define TracyPlot(name, value)
+#define TracyPlotConfig(name, type, step, fill, color)
+#define TracySecureAlloc(pointer, size)
+#define TracySecureFree(pointer)
+#endif
@@ -0,0 +1,66 @@
+#include "projects.h"
+
+#include <fstream>
+#include <iomanip>
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+
+void SaveProjects(const std::vector<Project>& projects, const std::string& file_path)
+{
+    ZoneScoped;
+    json j;
+    for (const auto& p : projects)
+    {
+        j["projects"].push_back({
+            {"name", p.name},
+            {"root_paths", p.root_paths},
+            {"selected_paths", p.selected_paths}
+        });
+    }
+
+    std::ofstream o(file_path);
+    o << std::setw(4) << j << std::endl;
+}
+
+// Runs on a worker thread at startup, so it returns the list instead of
+// touching the UI's project list directly.
+std::vector<Project> LoadProjects(const std::string& file_path)
+{
+    ZoneScoped;
+    std::vector<Project> loaded;
+    std::ifstream i(file_path);
+    if (!i.is_open()) {
+        return loaded; // No projects file yet, which is fine.
+    }
+
+    json j;
+    i >> j;
+
+    if (j.contains("projects"))
+    {
+        for (const auto& item : j["projects"])
+        {
+            Project p;
+            p.name = item.value("name", "Unnamed");
+            if (item.contains("root_paths")) {
+                p.root_paths = item["root_paths"].get<std::vector<std::string>>();
+            } else {
+                p.root_paths.push_back(item.value("root_path", ".")); // Written before projects had several roots
+            }
+            if (p.root_paths.empty()) {
+                p.root_paths.push_back(".");
+            }
+            if (item.contains("selected_paths")) {
+                p.selected_paths = item["selected_paths"].get<std::vector<std::string>>();
+            }
+            loaded.push_back(p);
+        }
+    }
+    return loaded;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct Project
+{
+    std::string name;
+    // The first root is the one shown in the Path field; the others are scanned and
+    // shown alongside it, and their selections go into the same generated context.
+    std::vector<std::string> root_paths;
+    std::vector<std::string> selected_paths;
+};
+
+void SaveProjects(const std::vector<Project>& projects, const std::string& file_path = "projects.json");
+// Returns the projects stored in file_path, or an empty list if there is no such file yet.
+std::vector<Project> LoadProjects(const std::string& file_path = "projects.json");
@@ -0,0 +1,157 @@
+#include "scan_index.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+
+#include "mapped_file.h"
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+
+static_assert(std::is_trivially_copyable<FileNode>::value, "FileNode is written to the scan index verbatim");
+
+struct ScanIndexHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t node_size;
+    uint64_t node_count;
+    uint64_t names_size;
+    uint64_t root_path_size;
+    uint32_t link_policy;
+    uint32_t reserved;
+};
+
+static const char kScanIndexMagic[8] = {'A', 'C', 'B', 'S', 'C', 'A', 'N', '\0'};
+static const char* kScanIndexDirectory = "scan_index";
+
+static uint64_t AlignTo8(uint64_t value)
+{
+    return (value + 7) & ~uint64_t(7);
+}
+
+// FNV-1a; stable across compilers and runs, unlike std::hash.
+static uint64_t HashRootPath(const std::string& text)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : text)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+
+std::string ScanIndexPath(const std::string& root_path)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.idx", static_cast<unsigned long long>(HashRootPath(root_path)));
+    return (fs::path(kScanIndexDirectory) / name).string();
+}
+
+std::shared_ptr<const FileTree> LoadScanIndex(const std::string& root_path)
+{
+    ZoneScoped;
+    MappedFile file(ScanIndexPath(root_path));
+    if (!file.IsValid() || file.Size() < sizeof(ScanIndexHeader)) {
+        return nullptr;
+    }
+
+    ScanIndexHeader header;
+    std::memcpy(&header, file.Data(), sizeof(header));
+    if (std::memcmp(header.magic, kScanIndexMagic, sizeof(kScanIndexMagic)) != 0 ||
+        header.version != kScanIndexVersion ||
+        header.node_size != sizeof(FileNode) ||
+        header.link_policy > static_cast<uint32_t>(LinkPolicy::Deduplicate) ||
+        header.node_count == 0) {
+        return nullptr;
+    }
+
+    const uint64_t root_offset = sizeof(ScanIndexHeader);
+    const uint64_t nodes_offset = AlignTo8(root_offset + header.root_path_size);
+    const uint64_t names_offset = AlignTo8(nodes_offset + header.node_count * sizeof(FileNode));
+    if (names_offset + header.names_size != file.Size()) {
+        return nullptr;
+    }
+    if (file.View().substr(root_offset, header.root_path_size) != root_path) {
+        return nullptr; // Hash collision with another root
+    }
+
+    auto tree = std::make_shared<FileTree>();
+    tree->root_path = root_path;
+    tree->link_policy = static_cast<LinkPolicy>(header.link_policy);
+    tree->nodes.resize(header.node_count);
+    std::memcpy(tree->nodes.data(), file.Data() + nodes_offset, header.node_count * sizeof(FileNode));
+    tree->names.assign(file.Data() + names_offset, header.names_size);
+
+    // Cheap structural check so a corrupted file cannot send the UI out of bounds, or
+    // round in circles: parents come before their children, as the scan lays them out,
+    // and every child names the directory that lists it.
+    for (uint32_t i = 0; i < tree->nodes.size(); ++i)
+    {
+        const FileNode& node = tree->nodes[i];
+        if (uint64_t(node.name_offset) + node.name_length > tree->names.size() ||
+            (i > 0 && node.parent >= i) ||
+            uint64_t(node.first_child) + node.child_count > tree->nodes.size() ||
+            (node.child_count > 0 && node.first_child <= i)) {
+            return nullptr;
+        }
+        for (uint32_t child = node.first_child; child < node.first_child + node.child_count; ++child)
+        {
+            if (tree->nodes[child].parent != i) {
+                return nullptr;
+            }
+        }
+    }
+    return tree;
+}
+
+bool SaveScanIndex(const FileTree& tree)
+{
+    ZoneScoped;
+    std::error_code ec;
+    fs::create_directories(kScanIndexDirectory, ec);
+
+    ScanIndexHeader header = {};
+    std::memcpy(header.magic, kScanIndexMagic, sizeof(kScanIndexMagic));
+    header.version = kScanIndexVersion;
+    header.node_size = sizeof(FileNode);
+    header.node_count = tree.nodes.size();
+    header.names_size = tree.names.size();
+    header.root_path_size = tree.root_path.size();
+    header.link_policy = static_cast<uint32_t>(tree.link_policy);
+
+    // Write next to the final file and rename, so a crash never leaves a half-written index behind.
+    const std::string path = ScanIndexPath(tree.root_path);
+    const std::string temp_path = path + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+        static const char padding[8] = {};
+        auto pad = [&](uint64_t written) { out.write(padding, AlignTo8(written) - written); };
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(tree.root_path.data(), tree.root_path.size());
+        pad(sizeof(header) + tree.root_path.size());
+        out.write(reinterpret_cast<const char*>(tree.nodes.data()), tree.nodes.size() * sizeof(FileNode));
+        // FileNode is 8-byte aligned, so the node table always ends on a boundary.
+        out.write(tree.names.data(), tree.names.size());
+        if (!out) {
+            return false;
+        }
+    }
+
+    fs::rename(temp_path, path, ec);
+    if (ec) {
+        std::cerr << "Could not write scan index " << path << ": " << ec.message() << std::endl;
+        fs::remove(temp_path, ec);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "file_tree.h"
+
+// On-disk cache of a scanned FileTree, one file per root under scan_index/.
+//
+// Layout (native endianness, every section 8-byte aligned):
+//   ScanIndexHeader | root path bytes | FileNode[node_count] | names arena
+//
+// The file is memory mapped on load. Anything that does not match exactly
+// (magic, version, node size, root path, section sizes) is treated as "no index".
+static constexpr uint32_t kScanIndexVersion = 3;
+
+std::string ScanIndexPath(const std::string& root_path);
+
+// Returns nullptr if there is no usable index for root_path.
+std::shared_ptr<const FileTree> LoadScanIndex(const std::string& root_path);
+bool SaveScanIndex(const FileTree& tree);
@@ -0,0 +1,122 @@
+#include "selection.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "metrics.h"
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+
+std::map<std::string, SelectionState, std::less<>> directory_state_cache;
+uint64_t selection_generation = 0;
+
+
+// Both walks below recurse into the scanned tree, never the disk. A link cycle ends
+// there in an is_repeated node without children, and children are laid out after
+// their parent; only following children past `index` keeps the walk finite even if
+// a damaged tree says otherwise.
+static uint32_t FirstChildAfter(const FileNode& node, uint32_t index)
+{
+    return std::max(node.first_child, index + 1);
+}
+
+void SetSelectionRecursively(const FileTree& tree, uint32_t index, const fs::path& path, bool selected, SelectionMap& selection)
+{
+    selection[path.string()] = selected;
+    directory_state_cache.erase(path.string()); // Invalidate this directory's cache
+    selection_generation++;
+
+    const FileNode& node = tree.nodes[index];
+    for (uint32_t child = FirstChildAfter(node, index); child < node.first_child + node.child_count; ++child)
+    {
+        SetSelectionRecursively(tree, child, path / std::string(tree.Name(child)), selected, selection);
+    }
+}
+
+
+void InvalidateParentCaches(const fs::path& path)
+{
+    selection_generation++;
+    fs::path current = path;
+    while (current.has_parent_path())
+    {
+        fs::path parent = current.parent_path();
+
+        // Break condition: if the parent is the same as the current path,
+        // we have reached the root (e.g., "D:\"'s parent is "D:\").
+        if (parent == current) {
+            break;
+        }
+
+        directory_state_cache.erase(parent.string());
+        current = parent;
+    }
+}
+SelectionState CalculateAndCacheDirectoryState(const FileTree& tree, uint32_t index, std::string_view path, const SelectionMap& selection)
+{
+    ZoneScoped;
+    try {
+        // 1. Check cache first - This is the key optimization!
+        auto cached = directory_state_cache.find(path);
+        if (cached != directory_state_cache.end())
+        {
+            AddMetric(Metric::DirectoryStateCacheHits);
+            return cached->second;
+        }
+        AddMetric(Metric::DirectoryStateCacheMisses);
+
+        // --- If not in cache, calculate it ---
+        // The children come from the scanned tree, so this never touches the disk.
+        bool found_selected = false;
+        bool found_unselected = false;
+
+        const FileNode& node = tree.nodes[index];
+        if (node.child_count == 0) {
+            // Base case for empty directory
+            directory_state_cache.emplace(std::string(path), SelectionState::NotSelected);
+            return SelectionState::NotSelected;
+        }
+
+        std::string child_path;
+        for (uint32_t child = FirstChildAfter(node, index); child < node.first_child + node.child_count; ++child)
+        {
+            ZoneScopedN("Cache Calculation Iteration");
+            if (found_selected && found_unselected) break; // Early exit
+
+            child_path.assign(path);
+            AppendPathComponent(child_path, tree.Name(child));
+            if (tree.nodes[child].is_directory)
+            {
+                // Recursively call this function to ensure children are cached
+                SelectionState child_state = CalculateAndCacheDirectoryState(tree, child, child_path, selection);
+                if (child_state != SelectionState::NotSelected) found_selected = true;
+                if (child_state != SelectionState::FullySelected) found_unselected = true;
+            }
+            else // It's a file
+            {
+                auto entry = selection.find(child_path);
+                if (entry != selection.end() && entry->second) {
+                    found_selected = true;
+                } else {
+                    found_unselected = true;
+                }
+            }
+        }
+
+        SelectionState result = SelectionState::NotSelected;
+        if (found_selected && found_unselected) {
+            result = SelectionState::PartiallySelected;
+        } else if (found_selected) {
+            result = SelectionState::FullySelected;
+        }
+
+        // 2. Store the result in the cache before returning
+        directory_state_cache.emplace(std::string(path), result);
+        return result;
+    }  catch (std::exception e) {
+        std::cerr << "Error calculating directory state: " << e.what() << std::endl;
+        return SelectionState::NotSelected;
+    }
+}
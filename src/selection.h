@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <string_view>
+
+#include "file_tree.h"
+
+namespace fs = std::filesystem;
+
+// Selected paths. std::less<> lets the tree look paths up by string_view, so drawing
+// a frame does not have to build a std::string per visible node.
+using SelectionMap = std::map<std::string, bool, std::less<>>;
+
+enum class SelectionState {
+    NotSelected,
+    PartiallySelected,
+    FullySelected
+};
+
+// Tri-state of every directory computed so far, keyed by path string.
+// Entries are erased whenever something below the directory changes.
+extern std::map<std::string, SelectionState, std::less<>> directory_state_cache;
+
+// Bumped whenever the selection changes: by SetSelectionRecursively and
+// InvalidateParentCaches here, and by code that replaces the selection wholesale.
+// Views that summarise the selection compare it to know when to refresh.
+extern uint64_t selection_generation;
+
+void SetSelectionRecursively(const FileTree& tree, uint32_t index, const fs::path& path, bool selected, SelectionMap& selection);
+void InvalidateParentCaches(const fs::path& path);
+// A cache hit allocates nothing; `path` must be the node's path as FileTree::Path spells it.
+SelectionState CalculateAndCacheDirectoryState(const FileTree& tree, uint32_t index, std::string_view path, const SelectionMap& selection);
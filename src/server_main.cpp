@@ -0,0 +1,87 @@
+// Headless context server, for CI machines and anywhere without a display:
+//
+//   context_server [--socket PATH] [--workers N]
+//
+// Serves the same JSON-lines protocol as the app started with --serve (see
+// context_server.cpp) until interrupted. Run it from the directory holding
+// projects.json. Every project root is scanned at startup so the first request
+// for it finds a warm tree.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "context_server.h"
+#include "projects.h"
+#include "scan_index.h"
+
+static std::atomic<bool> interrupted{false};
+
+static void OnSignal(int)
+{
+    interrupted = true;
+}
+
+static int Usage()
+{
+    std::cerr << "Usage: context_server [--socket PATH] [--workers N]\n";
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    std::string socket_path = DefaultServerSocketPath();
+    size_t worker_count = 4;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (arg == "--workers" && i + 1 < argc) {
+            worker_count = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else {
+            return Usage();
+        }
+    }
+
+    ContextServer server;
+    if (!server.Start(socket_path, worker_count)) {
+        return 1;
+    }
+    std::signal(SIGINT, OnSignal);
+    std::signal(SIGTERM, OnSignal);
+    std::cerr << "Listening on " << socket_path << std::endl;
+
+    // Requests are already being served; a request for a root that is still warming
+    // up just scans it itself.
+    std::thread warm_up([&server] {
+        try {
+            for (const auto& project : LoadProjects())
+            {
+                for (const auto& root_path : project.root_paths)
+                {
+                    std::shared_ptr<const FileTree> indexed = LoadScanIndex(root_path);
+                    auto tree = std::make_shared<const FileTree>(ScanFileTree(root_path, &interrupted, indexed.get()));
+                    if (interrupted) {
+                        return; // Partial trees are never shared.
+                    }
+                    server.ShareTree(tree);
+                }
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Cannot warm up project trees: " << e.what() << std::endl;
+        }
+    });
+
+    while (!interrupted) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    warm_up.join();
+    server.Stop();
+    return 0;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define ACB_HAVE_SSE2 1
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Small byte-search helpers shared by the fuzzy finder and the content search.
+// They look at 16 bytes per step with SSE2 and fall back to memchr elsewhere.
+
+static constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+inline unsigned CountTrailingZeros(uint32_t mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+// Index of the first `c` in data[begin, end), or kNotFound.
+inline size_t FindByte(const char* data, size_t begin, size_t end, char c)
+{
+#ifdef ACB_HAVE_SSE2
+    const __m128i needle = _mm_set1_epi8(c);
+    size_t i = begin;
+    for (; i + 16 <= end; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+        if (mask) {
+            return i + CountTrailingZeros(mask);
+        }
+    }
+    for (; i < end; ++i)
+    {
+        if (data[i] == c) {
+            return i;
+        }
+    }
+    return kNotFound;
+#else
+    if (begin >= end) {
+        return kNotFound;
+    }
+    const void* found = std::memchr(data + begin, c, end - begin);
+    return found ? static_cast<size_t>(static_cast<const char*>(found) - data) : kNotFound;
+#endif
+}
+
+inline char FoldCase(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+inline bool EqualsAt(const char* text, const char* needle, size_t length, bool ignore_case)
+{
+    if (!ignore_case) {
+        return std::memcmp(text, needle, length) == 0;
+    }
+    for (size_t i = 0; i < length; ++i)
+    {
+        if (FoldCase(text[i]) != FoldCase(needle[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Index of the first occurrence of needle in data[0, size), or kNotFound.
+// With SSE2 it compares the first and last needle byte at 16 positions per step
+// and only verifies positions where both agree, which skips almost all of the text.
+inline size_t FindSubstring(const char* data, size_t size, const char* needle, size_t length, bool ignore_case)
+{
+    if (length == 0) {
+        return 0;
+    }
+    if (length > size) {
+        return kNotFound;
+    }
+    const size_t last_start = size - length; // Last position a match can begin at
+    size_t i = 0;
+
+#ifdef ACB_HAVE_SSE2
+    auto upper = [](char c) { return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c; };
+    const char first = ignore_case ? FoldCase(needle[0]) : needle[0];
+    const char last = ignore_case ? FoldCase(needle[length - 1]) : needle[length - 1];
+    const __m128i first_lower = _mm_set1_epi8(first);
+    const __m128i first_upper = _mm_set1_epi8(ignore_case ? upper(first) : first);
+    const __m128i last_lower = _mm_set1_epi8(last);
+    const __m128i last_upper = _mm_set1_epi8(ignore_case ? upper(last) : last);
+
+    for (; i + 16 <= last_start + 1; i += 16)
+    {
+        __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + length - 1));
+        __m128i eq_first = _mm_or_si128(_mm_cmpeq_epi8(block_first, first_lower), _mm_cmpeq_epi8(block_first, first_upper));
+        __m128i eq_last = _mm_or_si128(_mm_cmpeq_epi8(block_last, last_lower), _mm_cmpeq_epi8(block_last, last_upper));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(eq_first, eq_last)));
+        while (mask)
+        {
+            size_t candidate = i + CountTrailingZeros(mask);
+            if (EqualsAt(data + candidate, needle, length, ignore_case)) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for (; i <= last_start; ++i)
+    {
+        if (EqualsAt(data + i, needle, length, ignore_case)) {
+            return i;
+        }
+    }
+    return kNotFound;
+}
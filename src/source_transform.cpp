@@ -0,0 +1,267 @@
+#include "source_transform.h"
+
+#include <algorithm>
+#include <cctype>
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+
+SourceLanguage DetectLanguage(std::string_view path)
+{
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of("/\\");
+    if (dot == std::string_view::npos || (slash != std::string_view::npos && dot < slash)) {
+        return SourceLanguage::Unknown;
+    }
+    std::string extension(path.substr(dot + 1));
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    static const char* const c_family[] = {
+        "c", "h", "cc", "cpp", "cxx", "c++", "hh", "hpp", "hxx", "h++", "inl", "ipp", "tpp",
+        "m", "mm", "java", "cs", "cu", "cuh", "glsl", "hlsl", "frag", "vert",
+    };
+    for (const char* candidate : c_family)
+    {
+        if (extension == candidate) {
+            return SourceLanguage::CFamily;
+        }
+    }
+    static const char* const script[] = {"js", "jsx", "mjs", "cjs", "ts", "tsx", "mts", "cts"};
+    for (const char* candidate : script)
+    {
+        if (extension == candidate) {
+            return SourceLanguage::Script;
+        }
+    }
+    if (extension == "py" || extension == "pyw" || extension == "pyi") {
+        return SourceLanguage::Python;
+    }
+    return SourceLanguage::Unknown;
+}
+
+
+namespace {
+
+// Receives the lexer's output one character at a time and drops trailing
+// whitespace and repeated blank lines on the fly. Indentation is kept, and
+// characters inside literals go through Verbatim() untouched.
+class CompactWriter
+{
+public:
+    explicit CompactWriter(std::string& out) : out(out) {}
+
+    void Put(char c)
+    {
+        if (c == '\n')
+        {
+            pending_whitespace.clear();
+            if (line_has_content) {
+                out += '\n';
+                blank_lines = 0;
+            } else if (!out.empty() && ++blank_lines == 1) {
+                out += '\n'; // Keep a single blank line as a paragraph break
+            }
+            line_has_content = false;
+        }
+        else if (c == ' ' || c == '\t' || c == '\r')
+        {
+            pending_whitespace += c;
+        }
+        else
+        {
+            Verbatim(c);
+        }
+    }
+
+    void Verbatim(char c)
+    {
+        out += pending_whitespace;
+        pending_whitespace.clear();
+        out += c;
+        line_has_content = c != '\n';
+        blank_lines = 0;
+    }
+
+    void Finish()
+    {
+        while (out.size() >= 2 && out[out.size() - 1] == '\n' && out[out.size() - 2] == '\n') {
+            out.pop_back();
+        }
+    }
+
+private:
+    std::string& out;
+    std::string pending_whitespace;
+    bool line_has_content = false;
+    int blank_lines = 0;
+};
+
+bool IsIdentifierChar(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+} // namespace
+
+bool IsDigitSeparator(std::string_view text, size_t quote)
+{
+    // Back up to the start of the token the ' is attached to. Only a number takes
+    // separators; anything else in front is an encoding prefix (L'x', u8'x') or junk.
+    size_t start = quote;
+    while (start > 0 && IsIdentifierChar(text[start - 1])) {
+        start--;
+    }
+    return start < quote && std::isdigit(static_cast<unsigned char>(text[start]));
+}
+
+namespace {
+
+void StripCFamily(std::string_view in, CompactWriter& writer, bool script)
+{
+    const size_t n = in.size();
+    size_t i = 0;
+    while (i < n)
+    {
+        const char c = in[i];
+        const char next = i + 1 < n ? in[i + 1] : '\0';
+        const char previous = i > 0 ? in[i - 1] : '\0';
+
+        if (c == '/' && next == '/')
+        {
+            // Line comment; a trailing backslash continues it onto the next line.
+            i += 2;
+            while (i < n && in[i] != '\n')
+            {
+                if (in[i] == '\\' && i + 1 < n && in[i + 1] == '\n') {
+                    i++;
+                }
+                i++;
+            }
+        }
+        else if (c == '/' && next == '*')
+        {
+            size_t end = in.find("*/", i + 2);
+            end = (end == std::string_view::npos) ? n : end + 2;
+            // Keep a line break if the comment had one, so code after it does not
+            // join e.g. a preceding #define. Otherwise a space keeps tokens apart.
+            bool multiline = in.substr(i, end - i).find('\n') != std::string_view::npos;
+            writer.Put(multiline ? '\n' : ' ');
+            i = end;
+        }
+        else if (!script && c == 'R' && next == '"' && (!IsIdentifierChar(previous) || previous == '8' || previous == 'L' || previous == 'u' || previous == 'U'))
+        {
+            // C++ raw string: R"delim( ... )delim"
+            size_t open = in.find('(', i + 2);
+            if (open == std::string_view::npos || open - (i + 2) > 16) {
+                writer.Verbatim(c);
+                i++;
+                continue;
+            }
+            std::string closing = ")" + std::string(in.substr(i + 2, open - (i + 2))) + "\"";
+            size_t end = in.find(closing, open + 1);
+            end = (end == std::string_view::npos) ? n : end + closing.size();
+            for (; i < end; ++i) {
+                writer.Verbatim(in[i]);
+            }
+        }
+        else if (c == '"' || (c == '\'' && !IsDigitSeparator(in, i)) || (script && c == '`'))
+        {
+            // String or character literal. Only script template strings may span lines.
+            writer.Verbatim(c);
+            i++;
+            while (i < n && in[i] != c && (in[i] != '\n' || c == '`'))
+            {
+                if (in[i] == '\\' && i + 1 < n) {
+                    writer.Verbatim(in[i++]);
+                }
+                writer.Verbatim(in[i++]);
+            }
+            if (i < n && in[i] == c) {
+                writer.Verbatim(in[i++]);
+            }
+        }
+        else
+        {
+            writer.Put(c);
+            i++;
+        }
+    }
+}
+
+void StripPython(std::string_view in, CompactWriter& writer)
+{
+    const size_t n = in.size();
+    size_t i = 0;
+    while (i < n)
+    {
+        const char c = in[i];
+        if (c == '#')
+        {
+            while (i < n && in[i] != '\n') {
+                i++;
+            }
+        }
+        else if (c == '"' || c == '\'')
+        {
+            const bool triple = i + 2 < n && in[i + 1] == c && in[i + 2] == c;
+            const size_t quote_length = triple ? 3 : 1;
+            for (size_t q = 0; q < quote_length; ++q) {
+                writer.Verbatim(in[i++]);
+            }
+            while (i < n)
+            {
+                if (in[i] == '\\' && i + 1 < n) {
+                    writer.Verbatim(in[i++]);
+                    writer.Verbatim(in[i++]);
+                    continue;
+                }
+                if (!triple && in[i] == '\n') {
+                    break; // Unterminated single-line string; resume as code.
+                }
+                if (in[i] == c && (!triple || (i + 2 < n && in[i + 1] == c && in[i + 2] == c)))
+                {
+                    for (size_t q = 0; q < quote_length; ++q) {
+                        writer.Verbatim(in[i++]);
+                    }
+                    break;
+                }
+                writer.Verbatim(in[i++]);
+            }
+        }
+        else
+        {
+            writer.Put(c);
+            i++;
+        }
+    }
+}
+
+} // namespace
+
+
+std::string StripComments(std::string_view content, SourceLanguage language)
+{
+    ZoneScoped;
+    std::string out;
+    out.reserve(content.size());
+    CompactWriter writer(out);
+
+    switch (language)
+    {
+    case SourceLanguage::CFamily:
+    case SourceLanguage::Script:
+        StripCFamily(content, writer, language == SourceLanguage::Script);
+        break;
+    case SourceLanguage::Python:
+        StripPython(content, writer);
+        break;
+    case SourceLanguage::Unknown:
+        for (char c : content) {
+            writer.Put(c);
+        }
+        break;
+    }
+    writer.Finish();
+    return out;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+enum class SourceLanguage
+{
+    Unknown,
+    CFamily,    // C, C++, Java, C# and friends: // and /* */ comments, ' and " literals
+    Script,     // JavaScript / TypeScript: like CFamily, plus `template` strings
+    Python
+};
+
+enum class TransformMode
+{
+    None,
+    StripComments,
+    Outline         // Declarations and signatures only; see outline.h
+};
+
+// Guesses the language from the file extension.
+SourceLanguage DetectLanguage(std::string_view path);
+
+// Whether the ' at `quote` is a C++14 digit separator (1'000'000) rather than the
+// start of a character literal, with or without an encoding prefix (L'x', u8'x').
+bool IsDigitSeparator(std::string_view text, size_t quote);
+
+// Drops comments, trailing whitespace and runs of blank lines in a single pass.
+// String and character literals are left untouched, so "//" inside a string survives.
+// Unknown languages only get the whitespace clean-up.
+std::string StripComments(std::string_view content, SourceLanguage language);
@@ -0,0 +1,213 @@
+#include "text_diff.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+
+// Lines keep their '\n', so a last line without one never matches a line that has it.
+static std::vector<std::string_view> SplitLines(std::string_view text)
+{
+    std::vector<std::string_view> lines;
+    size_t start = 0;
+    while (start < text.size())
+    {
+        size_t end = text.find('\n', start);
+        end = end == std::string_view::npos ? text.size() : end + 1;
+        lines.push_back(text.substr(start, end - start));
+        start = end;
+    }
+    return lines;
+}
+
+// Marks the lines of `a` that a shortest edit script deletes and the lines of `b` it
+// inserts. The greedy forward search keeps the furthest point of every diagonal
+// after each step d; walking those back from the end recovers the script.
+// Returns false if more than max_edits edits are needed.
+static bool MarkEdits(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, int max_edits, char* deleted, char* inserted)
+{
+    const int n = static_cast<int>(a.size());
+    const int m = static_cast<int>(b.size());
+    const int max_d = std::min(n + m, max_edits);
+    const int offset = max_d + 1;
+    std::vector<int> v(2 * max_d + 3, 0);
+    std::vector<int> trace;   // v[-d..d] after step d, every other diagonal, packed from d * (d + 1) / 2
+
+    int final_d = -1;
+    for (int d = 0; d <= max_d && final_d < 0; ++d)
+    {
+        for (int k = -d; k <= d; k += 2)
+        {
+            int x = (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1])) ? v[offset + k + 1] : v[offset + k - 1] + 1;
+            int y = x - k;
+            while (x < n && y < m && a[x] == b[y]) {
+                ++x;
+                ++y;
+            }
+            v[offset + k] = x;
+            if (x >= n && y >= m) {
+                final_d = d;
+                break;
+            }
+        }
+        for (int k = -d; k <= d && final_d < 0; k += 2) {
+            trace.push_back(v[offset + k]);
+        }
+    }
+    if (final_d < 0) {
+        return false;
+    }
+
+    int x = n;
+    int y = m;
+    for (int d = final_d; d > 0; --d)
+    {
+        const int* previous = trace.data() + static_cast<size_t>(d - 1) * d / 2;
+        auto furthest = [&](int k) { return previous[(k + d - 1) / 2]; };
+        const int k = x - y;
+        const bool down = k == -d || (k != d && furthest(k - 1) < furthest(k + 1));
+        const int previous_k = down ? k + 1 : k - 1;
+        const int previous_x = furthest(previous_k);
+        const int previous_y = previous_x - previous_k;
+        if (down) {
+            inserted[previous_y] = 1;
+        } else {
+            deleted[previous_x] = 1;
+        }
+        x = previous_x;
+        y = previous_y;
+    }
+    return true;
+}
+
+static void AppendRange(std::string& diff, size_t begin, size_t count)
+{
+    // An empty range names the line before it, as diff -u does.
+    diff += std::to_string(count == 0 ? begin : begin + 1);
+    if (count != 1) {
+        diff += ',';
+        diff += std::to_string(count);
+    }
+}
+
+static void AppendLine(std::string& diff, char prefix, std::string_view line)
+{
+    diff += prefix;
+    diff.append(line.data(), line.size());
+    if (line.empty() || line.back() != '\n') {
+        diff += "\n\\ No newline at end of file\n";
+    }
+}
+
+bool UnifiedDiff(std::string_view before, std::string_view after, std::string& diff, int context_lines, int max_edits)
+{
+    ZoneScoped;
+    diff.clear();
+    const std::vector<std::string_view> old_lines = SplitLines(before);
+    const std::vector<std::string_view> new_lines = SplitLines(after);
+    const size_t old_count = old_lines.size();
+    const size_t new_count = new_lines.size();
+
+    // A common head and tail, usually most of the file, never enter the search.
+    size_t head = 0;
+    while (head < old_count && head < new_count && old_lines[head] == new_lines[head]) {
+        ++head;
+    }
+    size_t tail = 0;
+    while (tail < old_count - head && tail < new_count - head && old_lines[old_count - 1 - tail] == new_lines[new_count - 1 - tail]) {
+        ++tail;
+    }
+
+    // The search compares lines as numbers: equal text, equal id.
+    std::unordered_map<std::string_view, uint32_t> ids;
+    auto intern = [&](const std::vector<std::string_view>& lines, size_t end) {
+        std::vector<uint32_t> result;
+        result.reserve(end - head);
+        for (size_t i = head; i < end; ++i) {
+            result.push_back(ids.emplace(lines[i], static_cast<uint32_t>(ids.size())).first->second);
+        }
+        return result;
+    };
+    const std::vector<uint32_t> a = intern(old_lines, old_count - tail);
+    const std::vector<uint32_t> b = intern(new_lines, new_count - tail);
+
+    std::vector<char> deleted(old_count, 0);
+    std::vector<char> inserted(new_count, 0);
+    if (!MarkEdits(a, b, max_edits, deleted.data() + head, inserted.data() + head)) {
+        return false;
+    }
+
+    // --- Group the changes into hunks ---
+    // Unmarked lines pair up in order, so every run of them is as long on both sides.
+    struct Change
+    {
+        size_t old_begin, old_end, new_begin, new_end;
+    };
+    std::vector<Change> changes;
+    for (size_t i = 0, j = 0; i < old_count || j < new_count;)
+    {
+        if (i < old_count && j < new_count && !deleted[i] && !inserted[j]) {
+            ++i;
+            ++j;
+            continue;
+        }
+        Change change = {i, i, j, j};
+        while (i < old_count && deleted[i]) ++i;
+        while (j < new_count && inserted[j]) ++j;
+        if (i == change.old_begin && j == change.new_begin) {
+            break; // Cannot happen with a valid script; never loop on a bad one
+        }
+        change.old_end = i;
+        change.new_end = j;
+        changes.push_back(change);
+    }
+
+    const size_t context = static_cast<size_t>(std::max(context_lines, 0));
+    for (size_t first = 0; first < changes.size();)
+    {
+        // Changes whose contexts would touch or overlap share a hunk.
+        size_t last = first;
+        while (last + 1 < changes.size() && changes[last + 1].old_begin - changes[last].old_end <= 2 * context) {
+            ++last;
+        }
+        const size_t leading = std::min(context, changes[first].old_begin);
+        const size_t trailing = std::min(context, old_count - changes[last].old_end);
+        const size_t old_begin = changes[first].old_begin - leading;
+        const size_t new_begin = changes[first].new_begin - leading;
+        const size_t old_end = changes[last].old_end + trailing;
+        const size_t new_end = changes[last].new_end + trailing;
+
+        diff += "@@ -";
+        AppendRange(diff, old_begin, old_end - old_begin);
+        diff += " +";
+        AppendRange(diff, new_begin, new_end - new_begin);
+        diff += " @@\n";
+        for (size_t i = old_begin, j = new_begin; i < old_end || j < new_end;)
+        {
+            if (i < old_end && j < new_end && !deleted[i] && !inserted[j])
+            {
+                AppendLine(diff, ' ', old_lines[i]);
+                ++i;
+                ++j;
+                continue;
+            }
+            const size_t i_before = i;
+            const size_t j_before = j;
+            for (; i < old_end && deleted[i]; ++i) {
+                AppendLine(diff, '-', old_lines[i]);
+            }
+            for (; j < new_end && inserted[j]; ++j) {
+                AppendLine(diff, '+', new_lines[j]);
+            }
+            if (i == i_before && j == j_before) {
+                break;
+            }
+        }
+        first = last + 1;
+    }
+    return true;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Line-based unified diff of `before` against `after`, computed with Myers' O(ND)
+// algorithm. Only the hunks are written, "@@ -l,s +l,s @@" headers followed by " ",
+// "-" and "+" lines with `context_lines` of unchanged text around each change; the
+// caller says which file it is. A last line without a newline is followed by
+// "\ No newline at end of file", as with diff -u.
+// Returns false, leaving `diff` empty, when more than max_edits lines were inserted or
+// deleted: a diff that big is better replaced by the whole file.
+bool UnifiedDiff(std::string_view before, std::string_view after, std::string& diff, int context_lines = 3, int max_edits = 2000);
@@ -0,0 +1,296 @@
+#include "token_heatmap.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <utility>
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+
+// --- Totals ---
+// Marks the selected files below `dir`, whose path is `path`. Paths are built in one
+// reused buffer, exactly as FileTree::Path spells them, so they match selection keys.
+static void CountSelectedFiles(const FileTree& tree, uint32_t dir, std::string& path, const SelectionMap& selection,
+                               std::vector<SubtreeTotals>& totals)
+{
+    const FileNode& node = tree.nodes[dir];
+    const size_t path_length = path.size();
+    for (uint32_t child = node.first_child; child < node.first_child + node.child_count; ++child)
+    {
+        AppendPathComponent(path, tree.Name(child));
+        if (tree.nodes[child].is_directory) {
+            CountSelectedFiles(tree, child, path, selection, totals);
+        } else {
+            auto entry = selection.find(path);
+            if (entry != selection.end() && entry->second) {
+                totals[child].selected_tokens = totals[child].tokens;
+            }
+        }
+        path.resize(path_length);
+    }
+}
+
+std::shared_ptr<const TreeTotals> ComputeTreeTotals(std::shared_ptr<const FileTree> tree, const SelectionMap& selection)
+{
+    ZoneScoped;
+    auto result = std::make_shared<TreeTotals>();
+    result->tree = tree;
+    std::vector<SubtreeTotals>& totals = result->nodes;
+    totals.resize(tree->nodes.size());
+    if (totals.empty()) {
+        return result;
+    }
+
+    // Sizes, tokens and file counts were already rolled up by the scanner.
+    for (size_t i = 0; i < tree->nodes.size(); ++i)
+    {
+        const FileNode& node = tree->nodes[i];
+        totals[i].bytes = node.size;
+        totals[i].tokens = node.token_count;
+        totals[i].files = node.file_count;
+    }
+    if (selection.empty()) {
+        return result;
+    }
+    std::string path = tree->root_path;
+    CountSelectedFiles(*tree, 0, path, selection, totals);
+    for (size_t i = totals.size() - 1; i > 0; --i) {
+        totals[tree->nodes[i].parent].selected_tokens += totals[i].selected_tokens;
+    }
+    return result;
+}
+
+
+// --- Treemap layout ---
+using TreemapItems = std::vector<std::pair<uint32_t, double>>;   // Node and its value, biggest first
+
+static double MetricValue(const SubtreeTotals& totals, TreemapMetric metric)
+{
+    return static_cast<double>(metric == TreemapMetric::AllTokens ? totals.tokens : totals.selected_tokens);
+}
+
+static TreemapItems ChildItems(const TreeTotals& totals, uint32_t dir, TreemapMetric metric)
+{
+    const FileNode& node = totals.tree->nodes[dir];
+    TreemapItems items;
+    items.reserve(node.child_count);
+    for (uint32_t child = node.first_child; child < node.first_child + node.child_count; ++child)
+    {
+        const double value = MetricValue(totals.nodes[child], metric);
+        if (value > 0.0) {
+            items.emplace_back(child, value);
+        }
+    }
+    std::sort(items.begin(), items.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+    return items;
+}
+
+// Rows of cells are laid along the shorter side of what is left of the rectangle.
+// A row keeps taking the next (smaller) item while that brings its worst aspect
+// ratio closer to 1; then it is fixed and the rest goes into the remaining space.
+static void Squarify(const TreemapItems& items, float x, float y, float width, float height, uint8_t depth,
+                     std::vector<TreemapCell>& cells)
+{
+    double total = 0.0;
+    for (const auto& item : items) {
+        total += item.second;
+    }
+    if (total <= 0.0 || width < 1.0f || height < 1.0f) {
+        return;
+    }
+    const double area_per_unit = static_cast<double>(width) * height / total;
+
+    size_t begin = 0;
+    while (begin < items.size() && width > 0.0f && height > 0.0f)
+    {
+        const double side = std::min(width, height);
+        double row_area = 0.0;
+        double min_area = std::numeric_limits<double>::max();
+        double max_area = 0.0;
+        double worst = std::numeric_limits<double>::max();
+        size_t end = begin;
+        for (; end < items.size(); ++end)
+        {
+            const double area = items[end].second * area_per_unit;
+            const double new_row = row_area + area;
+            const double new_min = std::min(min_area, area);
+            const double new_max = std::max(max_area, area);
+            const double new_worst = std::max(side * side * new_max / (new_row * new_row), new_row * new_row / (side * side * new_min));
+            if (end > begin && new_worst > worst) {
+                break;
+            }
+            row_area = new_row;
+            min_area = new_min;
+            max_area = new_max;
+            worst = new_worst;
+        }
+
+        const float thickness = static_cast<float>(row_area / side);
+        float offset = 0.0f;
+        for (size_t i = begin; i < end; ++i)
+        {
+            const float length = static_cast<float>(items[i].second * area_per_unit / thickness);
+            TreemapCell cell;
+            cell.node = items[i].first;
+            cell.depth = depth;
+            if (width >= height) {
+                cell.x = x;
+                cell.y = y + offset;
+                cell.width = thickness;
+                cell.height = length;
+            } else {
+                cell.x = x + offset;
+                cell.y = y;
+                cell.width = length;
+                cell.height = thickness;
+            }
+            offset += length;
+            // Slivers below a pixel cannot be seen or clicked; leave them out.
+            if (cell.width >= 1.0f && cell.height >= 1.0f) {
+                cells.push_back(cell);
+            }
+        }
+        if (width >= height) {
+            x += thickness;
+            width -= thickness;
+        } else {
+            y += thickness;
+            height -= thickness;
+        }
+        begin = end;
+    }
+}
+
+std::vector<TreemapCell> LayoutTreemap(const TreeTotals& totals, uint32_t focus, float width, float height, TreemapMetric metric)
+{
+    ZoneScoped;
+    std::vector<TreemapCell> cells;
+    if (focus >= totals.nodes.size()) {
+        return cells;
+    }
+    Squarify(ChildItems(totals, focus, metric), 0.0f, 0.0f, width, height, 0, cells);
+
+    // One level of nesting shows what is inside each big directory without a click.
+    static constexpr float kPadding = 2.0f;
+    static constexpr float kMinNestedSize = 24.0f;
+    const size_t top_level = cells.size();
+    for (size_t i = 0; i < top_level; ++i)
+    {
+        const TreemapCell cell = cells[i];
+        if (!totals.tree->nodes[cell.node].is_directory ||
+            cell.width < 2 * kPadding + kMinNestedSize || cell.height < kTreemapLabelHeight + kPadding + kMinNestedSize) {
+            continue;
+        }
+        Squarify(ChildItems(totals, cell.node, metric), cell.x + kPadding, cell.y + kTreemapLabelHeight,
+                 cell.width - 2 * kPadding, cell.height - kTreemapLabelHeight - kPadding, 1, cells);
+    }
+    return cells;
+}
+
+
+// --- Background jobs ---
+template <typename T>
+static bool IsReady(const std::future<T>& future)
+{
+    return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+bool TokenHeatmap::Poll(const std::shared_ptr<const FileTree>& tree, const SelectionMap& selection)
+{
+    bool updated = false;
+    if (IsReady(counting))
+    {
+        totals = counting.get();
+        updated = true;
+    }
+    if (IsReady(laying_out))
+    {
+        layout = laying_out.get();
+        updated = true;
+    }
+
+    // Only one count runs at a time; whatever changed meanwhile is picked up by the next.
+    if (tree && !counting.valid() && (tree != counted_tree || selection_generation != counted_generation))
+    {
+        counted_tree = tree;
+        counted_generation = selection_generation;
+        auto snapshot = std::make_shared<const SelectionMap>(selection);
+        counting = std::async(std::launch::async, [tree, snapshot, callback = on_update]() {
+            std::shared_ptr<const TreeTotals> result = ComputeTreeTotals(tree, *snapshot);
+            if (callback) {
+                callback();
+            }
+            return result;
+        });
+    }
+    if (layout_requested && !LayoutIsCurrent()) {
+        StartLayout();
+    }
+    return updated;
+}
+
+void TokenHeatmap::RequestLayout(uint32_t focus, float width, float height, TreemapMetric metric)
+{
+    wanted_layout.focus = focus;
+    wanted_layout.width = width;
+    wanted_layout.height = height;
+    wanted_layout.metric = metric;
+    layout_requested = true;
+    if (!LayoutIsCurrent()) {
+        StartLayout();
+    }
+}
+
+bool TokenHeatmap::LayoutIsCurrent() const
+{
+    return layout && layout->totals == totals && layout->focus == wanted_layout.focus && layout->width == wanted_layout.width &&
+           layout->height == wanted_layout.height && layout->metric == wanted_layout.metric;
+}
+
+void TokenHeatmap::StartLayout()
+{
+    if (!totals || laying_out.valid()) {
+        return; // Retried from Poll once the totals exist or the running layout is in
+    }
+    auto request = std::make_shared<TreemapLayout>(wanted_layout);
+    request->totals = totals;
+    laying_out = std::async(std::launch::async, [request, callback = on_update]() -> std::shared_ptr<const TreemapLayout> {
+        request->cells = LayoutTreemap(*request->totals, request->focus, request->width, request->height, request->metric);
+        if (callback) {
+            callback();
+        }
+        return request;
+    });
+}
+
+
+// --- Labels ---
+void FormatTokenCount(char* buffer, size_t size, uint64_t tokens)
+{
+    if (tokens < 1000) {
+        snprintf(buffer, size, "%llu", static_cast<unsigned long long>(tokens));
+    } else if (tokens < 1000 * 1000) {
+        snprintf(buffer, size, "%.1fk", tokens / 1e3);
+    } else if (tokens < 1000 * 1000 * 1000) {
+        snprintf(buffer, size, "%.1fM", tokens / 1e6);
+    } else {
+        snprintf(buffer, size, "%.1fG", tokens / 1e9);
+    }
+}
+
+void FormatByteCount(char* buffer, size_t size, uint64_t bytes)
+{
+    if (bytes < 1024) {
+        snprintf(buffer, size, "%llu B", static_cast<unsigned long long>(bytes));
+    } else if (bytes < 1024 * 1024) {
+        snprintf(buffer, size, "%.1f KB", bytes / 1024.0);
+    } else if (bytes < 1024ull * 1024 * 1024) {
+        snprintf(buffer, size, "%.1f MB", bytes / (1024.0 * 1024.0));
+    } else {
+        snprintf(buffer, size, "%.1f GB", bytes / (1024.0 * 1024.0 * 1024.0));
+    }
+}
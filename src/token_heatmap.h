@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "file_tree.h"
+#include "selection.h"
+
+// What a subtree would contribute to a generated context. A file counts itself.
+struct SubtreeTotals
+{
+    uint64_t bytes = 0;
+    uint64_t tokens = 0;            // Same size / 4 estimate as GenerateContext
+    uint64_t selected_tokens = 0;   // Tokens of the selected files only
+    uint32_t files = 0;
+};
+
+// Totals for every node of one tree snapshot, indexed like tree->nodes.
+struct TreeTotals
+{
+    std::shared_ptr<const FileTree> tree;
+    std::vector<SubtreeTotals> nodes;
+};
+
+// Bytes, tokens and files come from the scanner's roll-up in the nodes. The selected
+// tokens are summed here, bottom-up in a single reverse pass: the tree is stored
+// breadth-first, so every child comes after its parent.
+std::shared_ptr<const TreeTotals> ComputeTreeTotals(std::shared_ptr<const FileTree> tree, const SelectionMap& selection);
+
+enum class TreemapMetric
+{
+    AllTokens,
+    SelectedTokens
+};
+
+// One rectangle of a treemap. Depth 0 cells are the children of the focused
+// directory; depth 1 cells are their children, nested inside them.
+struct TreemapCell
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float width = 0.0f;
+    float height = 0.0f;
+    uint32_t node = 0;
+    uint8_t depth = 0;
+};
+
+struct TreemapLayout
+{
+    std::shared_ptr<const TreeTotals> totals;
+    uint32_t focus = 0;
+    float width = 0.0f;
+    float height = 0.0f;
+    TreemapMetric metric = TreemapMetric::AllTokens;
+    std::vector<TreemapCell> cells;   // Parents before the cells nested inside them
+};
+
+// Height of the strip at the top of a directory cell that holds its name, above
+// the nested cells of its children.
+static constexpr float kTreemapLabelHeight = 16.0f;
+
+// Squarified treemap (Bruls, Huizing and van Wijk) of the children of `focus`, each
+// with an area proportional to its tokens. Directories big enough to show their
+// contents get their own children laid out inside, below a strip for the name.
+std::vector<TreemapCell> LayoutTreemap(const TreeTotals& totals, uint32_t focus, float width, float height, TreemapMetric metric);
+
+// Keeps the totals and the treemap of a tree current without ever blocking the UI:
+// counting and layout both run on worker threads, and Poll just picks up what has
+// finished. A tree or selection that changes while a job runs is counted again once
+// it is done, so a burst of clicks costs one extra recount, not one per click.
+class TokenHeatmap
+{
+public:
+    // Called on the worker thread when a result is ready, like BackgroundScan's.
+    void SetUpdateCallback(std::function<void()> callback) { on_update = std::move(callback); }
+
+    // Call once per frame. Recounts when the tree or the selection changed since the
+    // current totals (see selection_generation); the selection is copied, so the UI
+    // can keep editing it meanwhile. Returns true when new totals or a new layout arrived.
+    bool Poll(const std::shared_ptr<const FileTree>& tree, const SelectionMap& selection);
+    // Lays out `focus` once totals exist. Asking again for the same thing is free.
+    void RequestLayout(uint32_t focus, float width, float height, TreemapMetric metric);
+
+    bool IsRunning() const { return counting.valid() || laying_out.valid(); }
+    // Totals for the tree most recently passed to Poll, or an older tree while those are counted.
+    std::shared_ptr<const TreeTotals> Totals() const { return totals; }
+    std::shared_ptr<const TreemapLayout> Layout() const { return layout; }
+
+private:
+    bool LayoutIsCurrent() const;
+    void StartLayout();
+
+    std::shared_ptr<const TreeTotals> totals;
+    std::shared_ptr<const TreemapLayout> layout;
+    std::future<std::shared_ptr<const TreeTotals>> counting;
+    std::future<std::shared_ptr<const TreemapLayout>> laying_out;
+
+    // What the totals in hand (or being counted) were computed from.
+    std::shared_ptr<const FileTree> counted_tree;
+    uint64_t counted_generation = 0;
+
+    TreemapLayout wanted_layout;   // Parameters of the latest request; its cells stay empty
+    bool layout_requested = false;
+    std::function<void()> on_update;
+};
+
+// Compact figures for labels: "950", "12.3k", "4.1M" tokens and "820 B", "1.4 MB".
+void FormatTokenCount(char* buffer, size_t size, uint64_t tokens);
+void FormatByteCount(char* buffer, size_t size, uint64_t bytes);
@@ -0,0 +1,190 @@
+#include "tree_view.h"
+
+#include <algorithm>
+
+#include "imgui.h"
+#include "frame_arena.h"
+#include "selection.h"
+
+// --- Tracy Profiler ---
+#include "profiling.h"
+
+
+// Frame in which SetDirectoryTreeOpen was called, and the state it asked for.
+static int open_all_frame = -1;
+static bool open_all = false;
+
+void SetDirectoryTreeOpen(bool open)
+{
+    open_all_frame = ImGui::GetFrameCount();
+    open_all = open;
+}
+
+// Clickable "[X]" drawn over a text icon, as used by both the tree and the find results.
+static bool IconButton(const char* icon)
+{
+    ImGui::TextUnformatted(icon);
+    ImGui::SameLine();
+    ImGui::SetCursorPosX(ImGui::GetCursorPosX() - ImGui::CalcTextSize(icon).x - ImGui::GetStyle().ItemSpacing.x);
+    const bool clicked = ImGui::InvisibleButton("##select", ImGui::CalcTextSize(icon));
+    ImGui::SameLine();
+    return clicked;
+}
+
+// Marks entries the scanner reached through a link, or did not descend into (see LinkPolicy).
+static const char* LinkSuffix(const FileNode& node)
+{
+    if (node.is_repeated) {
+        return node.is_symlink ? " (link, already in tree)" : " (already in tree)";
+    }
+    return node.is_symlink ? " (link)" : "";
+}
+
+// Token and byte totals after a node's name, straight from the scanned tree. The
+// selected share, from the heatmap's totals, only when part of the node is selected.
+static void DrawTotals(const FileNode& node, const SubtreeTotals* totals)
+{
+    char tokens[32], bytes[32];
+    FormatTokenCount(tokens, sizeof(tokens), node.token_count);
+    FormatByteCount(bytes, sizeof(bytes), node.size);
+    ImGui::SameLine();
+    if (totals && totals->selected_tokens > 0 && totals->selected_tokens < totals->tokens)
+    {
+        char selected[32];
+        FormatTokenCount(selected, sizeof(selected), totals->selected_tokens);
+        ImGui::TextDisabled("%s tok, %s (%s selected)", tokens, bytes, selected);
+    }
+    else if (node.is_directory)
+    {
+        ImGui::TextDisabled("%u files, %s tok, %s", node.file_count, tokens, bytes);
+    }
+    else
+    {
+        ImGui::TextDisabled("%s tok", tokens);
+    }
+}
+
+static bool IsSelected(const SelectionMap& selection, std::string_view path)
+{
+    auto entry = selection.find(path);
+    return entry != selection.end() && entry->second;
+}
+
+void DrawDirectoryTree(const FileTree& tree, uint32_t index, std::string_view path, SelectionMap& selection, const TreeTotals* totals)
+{
+    ZoneScoped;
+    // The scanner already stored the children directories-first and sorted by name,
+    // so we can render them straight from the tree model without touching the disk.
+    // Paths are built in the frame arena and looked up by string_view, and ImGui IDs
+    // come from the name range, so a steady-state frame makes no heap allocations.
+    FrameArena& arena = GetFrameArena();
+    const FileNode& node = tree.nodes[index];
+    const uint32_t first_file = std::find_if(tree.nodes.begin() + node.first_child, tree.nodes.begin() + node.first_child + node.child_count,
+                                             [](const FileNode& n) { return !n.is_directory; }) - tree.nodes.begin();
+
+    // --- Render Directories with 3-state logic ---
+    for (uint32_t child = node.first_child; child < first_file; ++child)
+    {
+        const std::string_view filename = tree.Name(child);
+        const std::string_view entry_path = arena.JoinPath(path, filename);
+        SelectionState state = CalculateAndCacheDirectoryState(tree, child, entry_path, selection);
+
+        const char* icon = "[ ]";
+        if (state == SelectionState::FullySelected) {
+            icon = "[X]"; // Use a capital X instead of ✓
+        } else if (state == SelectionState::PartiallySelected) {
+            icon = "[~]";
+        }
+
+        ImGui::PushID(filename.data(), filename.data() + filename.size());
+        if (IconButton(icon))
+        {
+            // When clicked, a partial or unselected folder becomes fully selected.
+            // A fully selected folder becomes unselected.
+            bool new_selection_state = (state == SelectionState::NotSelected);
+            fs::path clicked_path(entry_path);
+            SetSelectionRecursively(tree, child, clicked_path, new_selection_state, selection);
+            InvalidateParentCaches(clicked_path);
+        }
+
+        if (open_all_frame == ImGui::GetFrameCount()) {
+            ImGui::SetNextItemOpen(open_all);
+        }
+        const bool node_open = ImGui::TreeNodeEx("##node", 0, "%.*s%s", static_cast<int>(filename.size()), filename.data(), LinkSuffix(tree.nodes[child]));
+        DrawTotals(tree.nodes[child], totals ? &totals->nodes[child] : nullptr);
+        if (node_open)
+        {
+            DrawDirectoryTree(tree, child, entry_path, selection, totals);
+            ImGui::TreePop();
+        }
+        ImGui::PopID();
+    }
+
+    // --- Render Files with normal checkbox ---
+    for (uint32_t child = first_file; child < node.first_child + node.child_count; ++child)
+    {
+        const std::string_view filename = tree.Name(child);
+        const std::string_view entry_path = arena.JoinPath(path, filename);
+        const bool is_selected = IsSelected(selection, entry_path);
+
+        ImGui::PushID(filename.data(), filename.data() + filename.size());
+        if (IconButton(is_selected ? "[X]" : "[ ]"))
+        {
+            selection[std::string(entry_path)] = !is_selected;
+            InvalidateParentCaches(fs::path(entry_path));
+        }
+        ImGui::TextUnformatted(filename.data(), filename.data() + filename.size());
+        if (tree.nodes[child].is_symlink)
+        {
+            ImGui::SameLine(0.0f, 0.0f);
+            ImGui::TextDisabled("%s", LinkSuffix(tree.nodes[child]));
+        }
+        DrawTotals(tree.nodes[child], totals ? &totals->nodes[child] : nullptr);
+        ImGui::PopID();
+    }
+}
+
+// The node's full path, built in the frame arena from its chain of parents.
+static std::string_view ArenaPath(const FileTree& tree, uint32_t node)
+{
+    FrameArena& arena = GetFrameArena();
+    std::string_view path = tree.root_path;
+    uint32_t depth = 0;
+    for (uint32_t i = node; i != 0; i = tree.nodes[i].parent) {
+        depth++;
+    }
+    uint32_t* chain = static_cast<uint32_t*>(arena.Allocate(depth * sizeof(uint32_t), alignof(uint32_t)));
+    for (uint32_t i = node, d = depth; i != 0; i = tree.nodes[i].parent) {
+        chain[--d] = i;
+    }
+    for (uint32_t d = 0; d < depth; ++d) {
+        path = arena.JoinPath(path, tree.Name(chain[d]));
+    }
+    return path;
+}
+
+void DrawFindResults(const FileTree& tree, const std::vector<FuzzyMatch>& matches, SelectionMap& selection)
+{
+    ZoneScoped;
+    for (const auto& match : matches)
+    {
+        const std::string_view entry_path = ArenaPath(tree, match.node);
+        const bool is_selected = IsSelected(selection, entry_path);
+
+        ImGui::PushID(static_cast<int>(match.node));
+        if (IconButton(is_selected ? "[X]" : "[ ]"))
+        {
+            selection[std::string(entry_path)] = !is_selected;
+            InvalidateParentCaches(fs::path(entry_path));
+        }
+        ImGui::TextUnformatted(entry_path.data(), entry_path.data() + entry_path.size());
+        ImGui::PopID();
+    }
+}
+
+
+void DrawContextViewer(std::string& text)
+{
+    ZoneScoped;
+    ImGui::InputTextMultiline("##source", &text[0], text.size(), ImVec2(-1, -1), ImGuiInputTextFlags_ReadOnly);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "file_tree.h"
+#include "fuzzy_finder.h"
+#include "selection.h"
+#include "token_heatmap.h"
+
+namespace fs = std::filesystem;
+
+// The directory tree and the generated-context viewer. Kept apart from main.cpp
+// so the headless frame benchmark draws exactly what the app draws.
+
+// `path` is the path of node `index`; for the root that is tree.root_path.
+// Every entry shows the token and byte counts the scanner rolled up; with `totals`
+// for this tree, partly selected entries also show how much of that is selected.
+void DrawDirectoryTree(const FileTree& tree, uint32_t index, std::string_view path, SelectionMap& selection,
+                       const TreeTotals* totals = nullptr);
+
+// Quick-open results: a flat list of files with the same clickable checkbox as the tree.
+void DrawFindResults(const FileTree& tree, const std::vector<FuzzyMatch>& matches, SelectionMap& selection);
+
+// Opens (or closes) every directory node that DrawDirectoryTree draws during the
+// current frame. Call it after ImGui::NewFrame and before drawing the tree.
+void SetDirectoryTreeOpen(bool open);
+
+// Read-only view of the generated context, filling the rest of the window.
+void DrawContextViewer(std::string& text);
@@ -0,0 +1,167 @@
+#include <cstdio>
+#include <fstream>
+
+#include "context_generator.h"
+#include "tests.h"
+
+static void WriteFile(const fs::path& path, const std::string& content)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << content;
+}
+
+// Everything a file's "--- path ---" header introduces, up to the next header.
+static std::string Section(const std::string& text, const std::string& path)
+{
+    const std::string header = "--- " + path + " ---\n";
+    const size_t begin = text.find(header);
+    if (begin == std::string::npos) {
+        return "(missing)";
+    }
+    const size_t body = begin + header.size();
+    const size_t next = text.find("\n--- ", body);
+    return text.substr(body, next == std::string::npos ? std::string::npos : next + 1 - body);
+}
+
+// One file reached through names with different extensions is one read, but not
+// one transform: each name is transformed as its own language.
+static void SameFileTests()
+{
+    const fs::path directory = TestDirectory("same_file");
+    const std::string source = "int a; // note\n";
+    WriteFile(directory / "a.c", source);
+    std::error_code ec;
+    fs::create_hard_link(directory / "a.c", directory / "b.txt", ec);
+    CHECK(!ec);
+    fs::create_symlink(directory / "a.c", directory / "c.c", ec);
+    CHECK(!ec);
+
+    const std::string a = (directory / "a.c").string();
+    const std::string b = (directory / "b.txt").string();
+    const std::string c = (directory / "c.c").string();
+    SelectionMap selection = {{a, true}, {b, true}, {c, true}};
+
+    ContextOptions options;
+    options.transform = TransformMode::StripComments;
+    std::string text;
+    ContextStats stats;
+    GenerateContext(selection, options, text, stats);
+    CHECK(Section(text, a).find("// note") == std::string::npos);
+    CHECK(Section(text, b).find("// note") != std::string::npos);
+    CHECK_EQ(Section(text, c), "(identical to " + a + ")\n");
+    CHECK_EQ(stats.duplicate_count, 1);
+
+    // Without deduplication every name gets the content its own transform gives.
+    options.deduplicate = false;
+    GenerateContext(selection, options, text, stats);
+    CHECK_EQ(Section(text, c), Section(text, a));
+    CHECK(Section(text, b).find("// note") != std::string::npos);
+}
+
+static std::string Streamed(const SelectionMap& selection, const ContextOptions& options, ContextStats& stats,
+                            ContextSnapshot* snapshot = nullptr)
+{
+    std::string text;
+    StreamContext(selection, options, stats, [&](std::string_view piece) { text += piece; }, 100, snapshot);
+    return text;
+}
+
+static bool SameSnapshot(const ContextSnapshot& a, const ContextSnapshot& b)
+{
+    if (a.files.size() != b.files.size()) {
+        return false;
+    }
+    for (const auto& [path, file] : a.files)
+    {
+        auto other = b.files.find(path);
+        if (other == b.files.end() || other->second.hash != file.hash || other->second.content != file.content) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Streaming loads a few files at a time, yet must say exactly what one batch over
+// the whole selection says: copies and second paths are found across batches, and
+// delta contexts still see every file.
+static void StreamTests()
+{
+    const fs::path directory = TestDirectory("stream");
+    SelectionMap selection;
+    auto add = [&](int number, const std::string& content) {
+        char name[32];
+        snprintf(name, sizeof(name), "f%03d.c", number);
+        WriteFile(directory / name, content);
+        selection[(directory / name).string()] = true;
+        return (directory / name).string();
+    };
+    for (int i = 0; i < 600; ++i) {
+        add(i, "int f" + std::to_string(i) + "(); // " + std::to_string(i) + "\n");
+    }
+    add(100, "same\n");
+    add(400, "same\n");   // A copy of f100, hundreds of files and several batches later
+    add(401, "same\n");
+    std::error_code ec;
+    fs::create_hard_link(directory / "f050.c", directory / "g450.c", ec);   // Read through another path, batches later
+    CHECK(!ec);
+    selection[(directory / "g450.c").string()] = true;
+    selection[directory.string()] = true;   // Directories are selected too, and skipped
+
+    for (bool deduplicate : {true, false})
+    {
+        for (TransformMode transform : {TransformMode::None, TransformMode::StripComments})
+        {
+            ContextOptions options;
+            options.deduplicate = deduplicate;
+            options.transform = transform;
+            options.batch_bytes = 1;
+            std::string whole;
+            ContextStats whole_stats;
+            ContextSnapshot whole_snapshot;
+            GenerateContext(selection, options, whole, whole_stats, &whole_snapshot);
+            ContextStats streamed_stats;
+            ContextSnapshot streamed_snapshot;
+            CHECK(Streamed(selection, options, streamed_stats, &streamed_snapshot) == whole);
+            CHECK_EQ(streamed_stats.file_count, whole_stats.file_count);
+            CHECK_EQ(streamed_stats.duplicate_count, whole_stats.duplicate_count);
+            CHECK_EQ(streamed_stats.tokens_saved, whole_stats.tokens_saved);
+            CHECK(SameSnapshot(streamed_snapshot, whole_snapshot));
+        }
+    }
+
+    ContextOptions options;
+    options.batch_bytes = 1;
+    std::string text;
+    ContextStats stats;
+    GenerateContext(selection, options, text, stats);
+    CHECK_EQ(stats.duplicate_count, 3);
+    CHECK(text.find("(identical to " + (directory / "f100.c").string() + ")") != std::string::npos);
+
+    // Against a snapshot: one file edited, one removed, one added.
+    ContextSnapshot since;
+    GenerateContext(selection, options, text, stats, &since);
+    add(10, "int edited();\n");
+    fs::remove(directory / "f520.c");
+    selection.erase((directory / "f520.c").string());
+    add(600, "int added();\n");
+    options.since = &since;
+    for (DeltaMode delta : {DeltaMode::ChangedFiles, DeltaMode::UnifiedDiffs})
+    {
+        options.delta = delta;
+        std::string whole;
+        ContextStats whole_stats;
+        GenerateContext(selection, options, whole, whole_stats);
+        ContextStats streamed_stats;
+        CHECK(Streamed(selection, options, streamed_stats) == whole);
+        CHECK_EQ(streamed_stats.added_count, 1);
+        CHECK_EQ(streamed_stats.modified_count, 1);
+        CHECK_EQ(streamed_stats.removed_count, 1);
+        CHECK_EQ(streamed_stats.unchanged_count, whole_stats.unchanged_count);
+    }
+}
+
+void RunContextTests()
+{
+    SameFileTests();
+    StreamTests();
+}
@@ -0,0 +1,34 @@
+#include "tests.h"
+#include "text_diff.h"
+
+void RunDiffTests()
+{
+    std::string diff;
+    CHECK(UnifiedDiff("a\nb\nc\n", "a\nB\nc\n", diff));
+    CHECK_EQ(diff, std::string("@@ -1,3 +1,3 @@\n a\n-b\n+B\n c\n"));
+
+    // Identical texts have no hunks at all.
+    diff.clear();
+    CHECK(UnifiedDiff("a\nb\n", "a\nb\n", diff));
+    CHECK_EQ(diff, std::string());
+
+    // Context is limited to context_lines around the change.
+    diff.clear();
+    CHECK(UnifiedDiff("1\n2\n3\n4\n5\n6\n7\n8\n9\n10\n", "1\n2\n3\n4\n5\n6\n7\n8\n9\nX\n", diff, 1));
+    CHECK_EQ(diff, std::string("@@ -9,2 +9,2 @@\n 9\n-10\n+X\n"));
+
+    // A missing final newline is marked, as diff -u does.
+    diff.clear();
+    CHECK(UnifiedDiff("a\nb", "a\nc", diff));
+    CHECK_EQ(diff, std::string("@@ -1,2 +1,2 @@\n a\n-b\n\\ No newline at end of file\n+c\n\\ No newline at end of file\n"));
+
+    // Everything inserted into an empty file.
+    diff.clear();
+    CHECK(UnifiedDiff("", "x\ny\n", diff));
+    CHECK_EQ(diff, std::string("@@ -0,0 +1,2 @@\n+x\n+y\n"));
+
+    // Too many edits: no diff, so the caller sends the whole file instead.
+    diff = "stale";
+    CHECK(!UnifiedDiff("", "x\ny\nz\n", diff, 3, 2));
+    CHECK_EQ(diff, std::string());
+}
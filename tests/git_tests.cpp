@@ -0,0 +1,138 @@
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+#include "git_repository.h"
+#include "tests.h"
+
+static void AppendBigEndian32(std::string& out, uint32_t value)
+{
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out += static_cast<char>((value >> shift) & 0xFF);
+    }
+}
+
+// A version 2 index of regular files, each `size` bytes, followed by `extensions`.
+// The closing checksum is left zero; ReadIndex does not verify it.
+static std::string MakeIndex(const std::vector<std::string>& paths, uint32_t size, uint32_t count, const std::string& extensions = "")
+{
+    std::string index = "DIRC";
+    AppendBigEndian32(index, 2);
+    AppendBigEndian32(index, count);
+    for (const std::string& path : paths)
+    {
+        const size_t start = index.size();
+        index.append(36, '\0');                           // ctime, mtime, dev, ino, mode, uid, gid
+        index.replace(start + 24, 4, "\x00\x00\x81\xA4", 4); // 0100644
+        AppendBigEndian32(index, size);
+        index.append(20, '\x11');                         // Object id
+        index += static_cast<char>(path.size() >> 8);
+        index += static_cast<char>(path.size() & 0xFF);
+        index += path;
+        index.append(8 - (index.size() - start) % 8, '\0'); // At least one NUL, then to a multiple of 8
+    }
+    index += extensions;
+    index.append(20, '\0');
+    return index;
+}
+
+static std::string MakeExtension(const char* signature, const std::string& content)
+{
+    std::string extension = signature;
+    AppendBigEndian32(extension, static_cast<uint32_t>(content.size()));
+    return extension + content;
+}
+
+static bool ReadIndexFile(const fs::path& work_tree, const std::string& content, GitIndex& index, std::string& error)
+{
+    std::ofstream(work_tree / ".git" / "index", std::ios::binary | std::ios::trunc) << content;
+    GitRepository repository;
+    if (!repository.Open(work_tree.string())) {
+        error = "no repository";
+        return false;
+    }
+    error.clear();
+    return repository.ReadIndex(index, error);
+}
+
+static void IndexTests()
+{
+    const fs::path work_tree = TestDirectory("git_index");
+    fs::create_directories(work_tree / ".git" / "objects");
+
+    GitIndex index;
+    std::string error;
+    const std::string valid = MakeIndex({"a.txt", "dir/b.txt"}, 5, 2);
+    CHECK(ReadIndexFile(work_tree, valid, index, error));
+    CHECK_EQ(index.entries.size(), size_t(2));
+    if (index.entries.size() == 2)
+    {
+        CHECK_EQ(index.Path(index.entries[0]), std::string_view("a.txt"));
+        CHECK_EQ(index.Path(index.entries[1]), std::string_view("dir/b.txt"));
+        CHECK_EQ(index.entries[1].mode, uint32_t(0100644));
+        CHECK_EQ(index.entries[1].size, uint32_t(5));
+    }
+
+    // Cut anywhere before the checksum, the index must fail with a reason, not read out of bounds.
+    const std::string body = valid.substr(0, valid.size() - 20);
+    for (size_t length = 0; length < body.size(); ++length)
+    {
+        const bool read = ReadIndexFile(work_tree, body.substr(0, length) + std::string(20, '\0'), index, error);
+        CHECK(!read);
+        CHECK(!read && !error.empty());
+    }
+
+    CHECK(!ReadIndexFile(work_tree, MakeIndex({"a.txt"}, 5, 0x7FFFFFFF), index, error));
+    CHECK(!error.empty());
+    CHECK(!ReadIndexFile(work_tree, "not an index at all, but long enough", index, error));
+    CHECK(!error.empty());
+}
+
+static void CacheTreeTests()
+{
+    const fs::path work_tree = TestDirectory("git_cache_tree");
+    fs::create_directories(work_tree / ".git" / "objects");
+    const std::vector<std::string> paths = {"a.txt", "dir/b.txt"};
+    const std::string id(20, '\x22');
+    using namespace std::string_literals;
+
+    GitIndex index;
+    std::string error;
+    CHECK(ReadIndexFile(work_tree, MakeIndex(paths, 5, 2, MakeExtension("TREE", "\0"s "2 1\n" + id + "dir\0"s "1 0\n" + id)), index, error));
+    CHECK(index.cache_tree.valid);
+    CHECK(index.cache_tree.Child("dir") != nullptr && index.cache_tree.Child("dir")->valid);
+
+    // A damaged cache tree is only a lost shortcut: the index still reads, without it.
+    const std::string damaged[] = {
+        "\0"s "2 99999999999\n" + id,          // More subtrees than could fit
+        "\0"s "2 1\n" + id + "dir\0"s "1 4",   // A number running into the end
+        "\0"s "2 1\n" + id + "dir\0"s "99999999999999999999999 0\n",
+        "\0"s "2 x\n" + id,
+        "\0"s "2",
+    };
+    for (const std::string& content : damaged)
+    {
+        CHECK(ReadIndexFile(work_tree, MakeIndex(paths, 5, 2, MakeExtension("TREE", content)), index, error));
+        CHECK_EQ(index.entries.size(), size_t(2));
+        CHECK(!index.cache_tree.valid && index.cache_tree.children.empty());
+    }
+}
+
+static void ObjectIdTests()
+{
+    GitObjectId id;
+    CHECK(GitObjectId::FromHex("0123456789ABCDEF0123456789abcdef01234567", id));
+    CHECK_EQ(id.ToHex(), std::string("0123456789abcdef0123456789abcdef01234567"));
+    CHECK(!GitObjectId::FromHex("0123", id));
+    CHECK(!GitObjectId::FromHex("g123456789abcdef0123456789abcdef01234567", id));
+    // The id git gives an empty file, and "hello\n".
+    CHECK_EQ(HashGitBlob("").ToHex(), std::string("e69de29bb2d1d6434b8b29ae775ad8c2e48c5391"));
+    CHECK_EQ(HashGitBlob("hello\n").ToHex(), std::string("ce013625030ba8dba906f756967f9e9ca394464a"));
+}
+
+void RunGitTests()
+{
+    ObjectIdTests();
+    IndexTests();
+    CacheTreeTests();
+}
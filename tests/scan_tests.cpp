@@ -0,0 +1,117 @@
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "file_tree.h"
+#include "fixture_generator.h"
+#include "scan_index.h"
+#include "tests.h"
+
+// Runs with the working directory moved to `directory`, where the scan index lives.
+struct ScopedCurrentPath
+{
+    explicit ScopedCurrentPath(const fs::path& directory) : previous(fs::current_path()) { fs::current_path(directory); }
+    ~ScopedCurrentPath() { fs::current_path(previous); }
+    fs::path previous;
+};
+
+static std::string ReadWholeFile(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+static void WriteWholeFile(const std::string& path, const std::string& content)
+{
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << content;
+}
+
+static void FixtureScanTests(const fs::path& root, const FixtureStats& stats)
+{
+    const FileTree tree = ScanFileTree(root.string());
+    CHECK_EQ(tree.nodes.size(), size_t(stats.directories + stats.files)); // The root counts as a directory
+    CHECK_EQ(uint64_t(tree.nodes[0].file_count), stats.files);
+    CHECK_EQ(tree.nodes[0].size, stats.bytes);
+
+    // A rescan against an unchanged tree reuses every listing and finds the same nodes.
+    const FileTree rescanned = ScanFileTree(root.string(), nullptr, &tree);
+    CHECK_EQ(rescanned.nodes.size(), tree.nodes.size());
+    CHECK_EQ(rescanned.names, tree.names);
+    CHECK_EQ(rescanned.nodes[0].size, tree.nodes[0].size);
+}
+
+// Writes the index, damages one copy of it with `damage`, and expects it to be refused.
+template <typename Damage>
+static void CheckDamagedIndexRefused(const FileTree& tree, const std::string& pristine, Damage damage)
+{
+    std::string damaged = pristine;
+    damage(damaged);
+    WriteWholeFile(ScanIndexPath(tree.root_path), damaged);
+    CHECK(LoadScanIndex(tree.root_path) == nullptr);
+}
+
+static void ScanIndexTests(const fs::path& root)
+{
+    const FileTree tree = ScanFileTree(root.string());
+    CHECK(SaveScanIndex(tree));
+    const std::shared_ptr<const FileTree> loaded = LoadScanIndex(tree.root_path);
+    CHECK(loaded != nullptr);
+    if (loaded)
+    {
+        CHECK_EQ(loaded->nodes.size(), tree.nodes.size());
+        CHECK_EQ(loaded->names, tree.names);
+    }
+    CHECK(LoadScanIndex(tree.root_path + "/elsewhere") == nullptr);
+
+    // Header, then the root path and the node table, each 8-byte aligned.
+    const std::string pristine = ReadWholeFile(ScanIndexPath(tree.root_path));
+    const size_t nodes_offset = (48 + tree.root_path.size() + 7) / 8 * 8;
+    auto node_field = [&](std::string& index, uint32_t node, size_t field) -> char* {
+        return &index[nodes_offset + node * sizeof(FileNode) + field];
+    };
+    auto set_field = [&](std::string& index, uint32_t node, size_t field, uint32_t value) {
+        std::memcpy(node_field(index, node, field), &value, sizeof(value));
+    };
+
+    CheckDamagedIndexRefused(tree, pristine, [](std::string& index) { index[0] = 'X'; });
+    CheckDamagedIndexRefused(tree, pristine, [](std::string& index) { index.pop_back(); });
+    CheckDamagedIndexRefused(tree, pristine, [](std::string& index) { index.resize(40); });
+    CheckDamagedIndexRefused(tree, pristine, [&](std::string& index) {
+        set_field(index, 1, offsetof(FileNode, parent), static_cast<uint32_t>(tree.nodes.size()));
+    });
+    CheckDamagedIndexRefused(tree, pristine, [&](std::string& index) {
+        set_field(index, 1, offsetof(FileNode, name_offset), static_cast<uint32_t>(tree.names.size()));
+    });
+    CheckDamagedIndexRefused(tree, pristine, [&](std::string& index) {
+        set_field(index, 0, offsetof(FileNode, child_count), static_cast<uint32_t>(tree.nodes.size()));
+    });
+    // In bounds, but circular: a parent after its child, a directory listing itself,
+    // and a child claimed by a directory that is not its parent.
+    CheckDamagedIndexRefused(tree, pristine, [&](std::string& index) {
+        set_field(index, 1, offsetof(FileNode, parent), 2);
+    });
+    CheckDamagedIndexRefused(tree, pristine, [&](std::string& index) {
+        set_field(index, 1, offsetof(FileNode, first_child), 1);
+    });
+    CheckDamagedIndexRefused(tree, pristine, [&](std::string& index) {
+        set_field(index, 2, offsetof(FileNode, parent), 1);
+    });
+}
+
+void RunScanTests()
+{
+    const fs::path directory = TestDirectory("scan");
+    FixtureSpec spec;
+    spec.depth = 2;
+    spec.fanout = 3;
+    spec.files_per_dir = 4;
+    spec.max_file_size = 2048;
+    const fs::path root = directory / "fixture";
+    const FixtureStats stats = CreateFixture(root, spec);
+    CHECK(stats.files > 0 && stats.directories > 1);
+
+    FixtureScanTests(root, stats);
+    ScopedCurrentPath in_directory(directory);
+    ScanIndexTests(root);
+}
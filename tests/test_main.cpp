@@ -0,0 +1,54 @@
+#include <cstring>
+#include <vector>
+
+#include "tests.h"
+
+int test_failures = 0;
+
+static fs::path test_root;
+
+fs::path TestDirectory(const std::string& name)
+{
+    const fs::path directory = test_root / name;
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+    return directory;
+}
+
+// Usage: ContextTests [SUITE...]
+// Runs every suite, or only the named ones (diff, transform, git, scan, context).
+int main(int argc, char** argv)
+{
+    struct Suite
+    {
+        const char* name;
+        void (*run)();
+    };
+    const std::vector<Suite> suites = {
+        {"diff", RunDiffTests},
+        {"transform", RunTransformTests},
+        {"git", RunGitTests},
+        {"scan", RunScanTests},
+        {"context", RunContextTests},
+    };
+
+    test_root = fs::temp_directory_path() / "context_tests";
+    fs::remove_all(test_root);
+    fs::create_directories(test_root);
+    for (const Suite& suite : suites)
+    {
+        bool wanted = argc == 1;
+        for (int i = 1; i < argc; ++i) {
+            wanted |= std::strcmp(argv[i], suite.name) == 0;
+        }
+        if (!wanted) {
+            continue;
+        }
+        const int failures_before = test_failures;
+        suite.run();
+        std::cout << (test_failures == failures_before ? "ok   " : "FAIL ") << suite.name << "\n";
+    }
+    std::error_code ec;
+    fs::remove_all(test_root, ec);
+    return test_failures == 0 ? 0 : 1;
+}
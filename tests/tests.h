@@ -0,0 +1,42 @@
+#pragma once
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+// A deliberately small harness: no framework dependency, just checks that report
+// where they failed and a non-zero exit code for ctest.
+extern int test_failures;
+
+#define CHECK(condition)                                                                      \
+    do {                                                                                      \
+        if (!(condition)) {                                                                   \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed\n";   \
+            test_failures++;                                                                  \
+        }                                                                                     \
+    } while (false)
+
+#define CHECK_EQ(actual, expected)                                                            \
+    do {                                                                                      \
+        const auto& actual_value = (actual);                                                  \
+        const auto& expected_value = (expected);                                              \
+        if (!(actual_value == expected_value)) {                                              \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_EQ(" #actual ", " #expected  \
+                      << ") failed\n  actual:   " << actual_value                             \
+                      << "\n  expected: " << expected_value << "\n";                          \
+            test_failures++;                                                                  \
+        }                                                                                     \
+    } while (false)
+
+// A fresh, empty directory under the system temp directory, removed again when the
+// suite ends.
+fs::path TestDirectory(const std::string& name);
+
+// Each tests/*_tests.cpp runs its checks here.
+void RunDiffTests();
+void RunTransformTests();
+void RunGitTests();
+void RunScanTests();
+void RunContextTests();
@@ -0,0 +1,69 @@
+#include "outline.h"
+#include "source_transform.h"
+#include "tests.h"
+
+static void StripCommentTests()
+{
+    CHECK_EQ(StripComments("int a = 1; // one\nint b = 2; /* two */\n", SourceLanguage::CFamily),
+             std::string("int a = 1;\nint b = 2;\n"));
+    // Literals are kept whole, comment markers inside them included.
+    CHECK_EQ(StripComments("const char* s = \"// not\";\nchar q = '\\'';  // gone\n", SourceLanguage::CFamily),
+             std::string("const char* s = \"// not\";\nchar q = '\\'';\n"));
+    CHECK_EQ(StripComments("auto r = R\"x(/* kept */)x\"; // gone\n", SourceLanguage::CFamily),
+             std::string("auto r = R\"x(/* kept */)x\";\n"));
+    // Digit separators are not character literals.
+    CHECK_EQ(StripComments("int n = 1'000'000; // gone\n", SourceLanguage::CFamily), std::string("int n = 1'000'000;\n"));
+    CHECK_EQ(StripComments("long h = 0xFF'FF; // gone\n", SourceLanguage::CFamily), std::string("long h = 0xFF'FF;\n"));
+    // Encoding prefixes still open a character literal, whatever it holds.
+    CHECK_EQ(StripComments("wchar_t w = L'\"'; // gone\n", SourceLanguage::CFamily), std::string("wchar_t w = L'\"';\n"));
+    CHECK_EQ(StripComments("auto a = u'\"', b = U'/', c = u8'\"'; // gone\n", SourceLanguage::CFamily),
+             std::string("auto a = u'\"', b = U'/', c = u8'\"';\n"));
+    // Runs of blank lines collapse to one.
+    CHECK_EQ(StripComments("a;\n\n\n\nb;\n", SourceLanguage::CFamily), std::string("a;\n\nb;\n"));
+    CHECK_EQ(StripComments("x = 1  # gone\ns = '# kept'\n", SourceLanguage::Python), std::string("x = 1\ns = '# kept'\n"));
+    CHECK_EQ(StripComments("let t = `// kept`; // gone\n", SourceLanguage::Script), std::string("let t = `// kept`;\n"));
+}
+
+static void OutlineTests()
+{
+    CHECK_EQ(ExtractOutline("#include <x>\n"
+                            "struct S {\n"
+                            "    int a;\n"
+                            "    void f() { return; }\n"
+                            "};\n"
+                            "int plain(int x) {\n"
+                            "    return x;\n"
+                            "}\n", SourceLanguage::CFamily),
+             std::string("#include <x>\n"
+                         "struct S {\n"
+                         "    int a;\n"
+                         "    void f() { ... }\n"
+                         "};\n"
+                         "int plain(int x) { ... }\n"));
+    // Container keywords inside a parameter list do not make a function a type.
+    CHECK_EQ(ExtractOutline("static int size_of(struct stat *st) {\n    return 1;\n}\n"
+                            "void set(int type) {\n    apply(type);\n}\n"
+                            "void g(enum E e) {\n    h(e);\n}\n"
+                            "template <class T> void t(T value) {\n    use(value);\n}\n", SourceLanguage::CFamily),
+             std::string("static int size_of(struct stat *st) { ... }\n"
+                         "void set(int type) { ... }\n"
+                         "void g(enum E e) { ... }\n"
+                         "template <class T> void t(T value) { ... }\n"));
+    // TypeScript's keywords only count in scripts; in C an initialiser stays collapsed.
+    CHECK_EQ(ExtractOutline("int type = {\n    1, 2\n};\n", SourceLanguage::CFamily), std::string("int type = { ... };\n"));
+    CHECK_EQ(ExtractOutline("export type Point = {\n    x: number;\n};\n", SourceLanguage::Script),
+             std::string("export type Point = {\n    x: number;\n};\n"));
+    CHECK_EQ(ExtractOutline("namespace n {\nstruct S {\n    int a;\n};\n}\n", SourceLanguage::CFamily),
+             std::string("namespace n {\nstruct S {\n    int a;\n};\n}\n"));
+    // A brace in a prefixed character literal does not end the body early.
+    CHECK_EQ(ExtractOutline("int f() {\n    return L'}' + 1'000;\n}\nint g();\n", SourceLanguage::CFamily),
+             std::string("int f() { ... }\nint g();\n"));
+    CHECK_EQ(ExtractOutline("def f(x):\n    return x\nclass C:\n    def m(self):\n        pass\n", SourceLanguage::Python),
+             std::string("def f(x):\n    ...\nclass C:\n    def m(self):\n        ...\n"));
+}
+
+void RunTransformTests()
+{
+    StripCommentTests();
+    OutlineTests();
+}
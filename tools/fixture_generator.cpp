@@ -0,0 +1,222 @@
+#include "fixture_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// std::mt19937_64 is fully specified by the standard, unlike the std:: distributions,
+// so everything below draws from it directly to stay identical across standard libraries.
+class FixtureRandom
+{
+public:
+    explicit FixtureRandom(uint64_t seed) : engine(seed) {}
+
+    uint64_t Next() { return engine(); }
+
+    // Uniform in [0, 1)
+    double Unit() { return static_cast<double>(engine() >> 11) * (1.0 / 9007199254740992.0); }
+
+    bool Chance(double probability) { return probability > 0.0 && Unit() < probability; }
+
+private:
+    std::mt19937_64 engine;
+};
+
+uint64_t DrawFileSize(const FixtureSpec& spec, FixtureRandom& random)
+{
+    const uint64_t low = spec.min_file_size;
+    const uint64_t high = std::max(spec.max_file_size, low);
+    if (spec.size_distribution == FileSizeDistribution::Uniform || low == 0) {
+        return low + static_cast<uint64_t>(random.Unit() * static_cast<double>(high - low + 1));
+    }
+    double size = static_cast<double>(low) * std::pow(static_cast<double>(high) / static_cast<double>(low), random.Unit());
+    return std::min(high, static_cast<uint64_t>(size));
+}
+
+// Text files come in a few languages so the comment-stripping and outline transforms
+// have real work to do.
+struct TextKind
+{
+    const char* extension;
+    std::vector<const char*> lines;
+};
+
+const TextKind kTextKinds[] = {
+    {"cpp", {
+        "#include <vector>\n",
+        "int value = compute(a, b); // adjust for the offset\n",
+        "    if (value > limit) { return value - limit; }\n",
+        "/* Block comment describing the next function in some detail. */\n",
+        "static void Process(const std::vector<int>& items)\n{\n    for (int item : items) { Handle(item); }\n}\n",
+        "const char* message = \"string with // not a comment\";\n",
+        "\n",
+    }},
+    {"h", {
+        "#pragma once\n",
+        "struct Point { int x; int y; };\n",
+        "// Returns the distance between two points.\n",
+        "double Distance(const Point& a, const Point& b);\n",
+        "\n",
+    }},
+    {"py", {
+        "import os\n",
+        "# Walk the tree and collect the sizes.\n",
+        "def collect(root):\n    \"\"\"Return the total size below root.\"\"\"\n    return sum(os.path.getsize(p) for p in walk(root))\n",
+        "class Config:\n    name = 'fixture'  # default\n",
+        "\n",
+    }},
+    {"md", {
+        "# Heading\n",
+        "Some prose about the module, wrapped at a reasonable width for reading.\n",
+        "- a bullet point\n",
+        "\n",
+    }},
+};
+
+void WriteFile(const fs::path& path, const std::string& content)
+{
+    std::ofstream file(path, std::ios::binary);
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    if (!file) {
+        throw fs::filesystem_error("Failed to write fixture file", path, std::make_error_code(std::errc::io_error));
+    }
+}
+
+void CreateDirectory(const fs::path& dir, const fs::path& root, const FixtureSpec& spec, int level, FixtureRandom& random, FixtureStats& stats)
+{
+    fs::create_directory(dir);
+    stats.directories++;
+
+    std::string content;
+    std::string first_file;
+    for (int f = 0; f < spec.files_per_dir; ++f)
+    {
+        // A symlink slot needs a real file in this directory to point at.
+        if (!first_file.empty() && random.Chance(spec.symlink_ratio))
+        {
+            std::error_code ec;
+            fs::create_symlink(first_file, dir / ("link_" + std::to_string(f)), ec);
+            if (ec) {
+                stats.skipped_symlinks++;
+            } else {
+                stats.symlinks++;
+            }
+            continue;
+        }
+
+        const uint64_t size = DrawFileSize(spec, random);
+        content.clear();
+        std::string name = "file_" + std::to_string(f);
+        if (random.Chance(spec.binary_ratio))
+        {
+            name += ".bin";
+            content.resize(size);
+            for (char& c : content) {
+                c = static_cast<char>(random.Next() & 0xFF);
+            }
+            stats.binary_files++;
+        }
+        else
+        {
+            const TextKind& kind = kTextKinds[random.Next() % std::size(kTextKinds)];
+            name += std::string(".") + kind.extension;
+            while (content.size() < size) {
+                content += kind.lines[random.Next() % kind.lines.size()];
+            }
+            content.resize(size);
+        }
+        WriteFile(dir / name, content);
+        stats.files++;
+        stats.bytes += size;
+        if (first_file.empty()) {
+            first_file = name;
+        }
+    }
+
+    if (level + 1 >= spec.depth || spec.fanout == 0)
+    {
+        if (spec.directory_cycles)
+        {
+            std::error_code ec;
+            fs::create_directory_symlink(fs::relative(root, dir), dir / "cycle", ec);
+            if (ec) {
+                stats.skipped_symlinks++;
+            } else {
+                stats.symlinks++;
+            }
+        }
+        return;
+    }
+    for (int d = 0; d < spec.fanout; ++d) {
+        CreateDirectory(dir / ("dir_" + std::to_string(d)), root, spec, level + 1, random, stats);
+    }
+}
+
+} // namespace
+
+
+bool FixturePreset(std::string_view name, FixtureSpec& spec)
+{
+    spec = FixtureSpec();
+    if (name == "wide") {
+        spec.depth = 1;
+        spec.fanout = 0;
+        spec.files_per_dir = 20000;
+        spec.max_file_size = 4096;
+    } else if (name == "deep") {
+        spec.depth = 40;
+        spec.fanout = 1;
+        spec.files_per_dir = 10;
+        spec.max_file_size = 4096;
+    } else if (name == "mixed") {
+        spec.depth = 4;
+        spec.fanout = 6;
+        spec.files_per_dir = 12;
+        spec.min_file_size = 16;
+        spec.max_file_size = 256 * 1024;
+        spec.binary_ratio = 0.05;
+        spec.symlink_ratio = 0.02;
+    } else if (name == "huge") {
+        // 10,101 directories with 100 files each: 1,010,100 files
+        spec.depth = 3;
+        spec.fanout = 100;
+        spec.files_per_dir = 100;
+        spec.min_file_size = 0;
+        spec.max_file_size = 256;
+        spec.size_distribution = FileSizeDistribution::Uniform;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+fs::path DefaultFixtureDirectory()
+{
+    std::error_code ec;
+    if (fs::is_directory("/dev/shm", ec)) {
+        return "/dev/shm";
+    }
+    return fs::temp_directory_path();
+}
+
+FixtureStats CreateFixture(const fs::path& root, const FixtureSpec& spec)
+{
+    if (fs::exists(root)) {
+        throw fs::filesystem_error("Fixture directory already exists", root, std::make_error_code(std::errc::file_exists));
+    }
+    if (root.has_parent_path()) {
+        fs::create_directories(root.parent_path());
+    }
+
+    FixtureStats stats;
+    FixtureRandom random(spec.seed);
+    const fs::path absolute_root = fs::absolute(root);
+    CreateDirectory(absolute_root, absolute_root, spec, 0, random, stats);
+    return stats;
+}
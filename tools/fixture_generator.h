@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+namespace fs = std::filesystem;
+
+enum class FileSizeDistribution
+{
+    Uniform,
+    LogUniform      // Most files small, a few large, like a real source tree
+};
+
+// Shape of a generated tree. Every directory above `depth` holds `fanout`
+// subdirectories; every directory holds `files_per_dir` files.
+struct FixtureSpec
+{
+    int depth = 3;
+    int fanout = 4;
+    int files_per_dir = 8;
+    uint64_t min_file_size = 64;
+    uint64_t max_file_size = 16 * 1024;
+    FileSizeDistribution size_distribution = FileSizeDistribution::LogUniform;
+    double binary_ratio = 0.0;      // Fraction of files filled with random bytes (NULs included)
+    double symlink_ratio = 0.0;     // Fraction of file slots that become a symlink to a sibling file
+    bool directory_cycles = false;  // Each leaf directory gets a symlink back to the fixture root
+    uint64_t seed = 1;
+};
+
+struct FixtureStats
+{
+    uint64_t directories = 0;
+    uint64_t files = 0;
+    uint64_t binary_files = 0;
+    uint64_t symlinks = 0;
+    uint64_t skipped_symlinks = 0;  // Not permitted here, e.g. Windows without developer mode
+    uint64_t bytes = 0;
+};
+
+// Fills `spec` with one of the named shapes: "wide", "deep", "mixed" or "huge"
+// (about 1M files). Returns false for an unknown name.
+bool FixturePreset(std::string_view name, FixtureSpec& spec);
+
+// /dev/shm when it exists, so fixtures live in RAM; the system temp directory otherwise.
+fs::path DefaultFixtureDirectory();
+
+// Creates the tree under `root`, which must not exist yet. The same spec and seed always
+// give the same names, sizes and contents, on any platform. Throws fs::filesystem_error.
+FixtureStats CreateFixture(const fs::path& root, const FixtureSpec& spec);
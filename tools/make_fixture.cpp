@@ -0,0 +1,87 @@
+// Command-line front end for the fixture generator:
+//
+//   make_fixture [--preset wide|deep|mixed|huge] [--depth N] [--fanout N] [--files N]
+//                [--min-size BYTES] [--max-size BYTES] [--uniform] [--binary-ratio R]
+//                [--symlink-ratio R] [--cycles] [--seed N] [OUTPUT_DIR]
+//
+// The preset is applied first and individual options override it. OUTPUT_DIR defaults
+// to a "fixture" directory under /dev/shm (or the temp directory) and must not exist.
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "fixture_generator.h"
+
+static int Usage()
+{
+    std::cerr << "Usage: make_fixture [--preset wide|deep|mixed|huge] [--depth N] [--fanout N] [--files N]\n"
+                 "                    [--min-size BYTES] [--max-size BYTES] [--uniform] [--binary-ratio R]\n"
+                 "                    [--symlink-ratio R] [--cycles] [--seed N] [OUTPUT_DIR]\n";
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    FixtureSpec spec;
+    fs::path output = DefaultFixtureDirectory() / "fixture";
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        auto needs_value = [&]() {
+            if (!value) {
+                std::cerr << arg << " needs a value\n";
+                std::exit(Usage());
+            }
+            i++;
+            return value;
+        };
+
+        if (arg == "--preset") {
+            if (!FixturePreset(needs_value(), spec)) {
+                std::cerr << "Unknown preset: " << value << "\n";
+                return Usage();
+            }
+        } else if (arg == "--depth") {
+            spec.depth = std::atoi(needs_value());
+        } else if (arg == "--fanout") {
+            spec.fanout = std::atoi(needs_value());
+        } else if (arg == "--files") {
+            spec.files_per_dir = std::atoi(needs_value());
+        } else if (arg == "--min-size") {
+            spec.min_file_size = std::strtoull(needs_value(), nullptr, 10);
+        } else if (arg == "--max-size") {
+            spec.max_file_size = std::strtoull(needs_value(), nullptr, 10);
+        } else if (arg == "--uniform") {
+            spec.size_distribution = FileSizeDistribution::Uniform;
+        } else if (arg == "--binary-ratio") {
+            spec.binary_ratio = std::atof(needs_value());
+        } else if (arg == "--symlink-ratio") {
+            spec.symlink_ratio = std::atof(needs_value());
+        } else if (arg == "--cycles") {
+            spec.directory_cycles = true;
+        } else if (arg == "--seed") {
+            spec.seed = std::strtoull(needs_value(), nullptr, 10);
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return Usage();
+        } else {
+            output = arg;
+        }
+    }
+
+    try {
+        FixtureStats stats = CreateFixture(output, spec);
+        std::cout << output.string() << ": " << stats.directories << " directories, " << stats.files << " files ("
+                  << stats.binary_files << " binary), " << stats.symlinks << " symlinks, " << stats.bytes << " bytes\n";
+        if (stats.skipped_symlinks > 0) {
+            std::cerr << stats.skipped_symlinks << " symlinks could not be created on this system\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error creating fixture: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}